@@ -22,8 +22,15 @@ public class TokebiAnalytics : ModuleRules
                 "Json",
                 "JsonUtilities",
                 "Settings",
-                "Projects"
+                "Projects",
+                "TraceLog"
             }
         );
+        
+        // Mock ingestion endpoints for the automation tests
+        if (Target.Configuration != UnrealTargetConfiguration.Shipping)
+        {
+            PrivateDependencyModuleNames.Add("HTTPServer");
+        }
     }
 }
\ No newline at end of file
@@ -38,6 +38,7 @@ public:
     {
         // Flush any remaining events before shutdown
         UTokebiAnalyticsFunctions::TokebiFlushEvents();
+        UTokebiAnalyticsFunctions::ShutdownTokebiSystem();
         
         // Unregister settings
         if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings"))
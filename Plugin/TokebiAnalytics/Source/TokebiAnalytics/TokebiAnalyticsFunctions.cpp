@@ -1,7 +1,13 @@
 #include "TokebiAnalyticsFunctions.h"
 #include "TokebiAnalyticsSettings.h"
+#include "TokebiAnalyticsTrace.h"
+#include "TokebiEndpointRouter.h"
+#include "TokebiCoalescingTable.h"
+#include "TokebiAnalyticsTestHelpers.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
 #include "HttpModule.h"
 #include "Interfaces/IHttpRequest.h"
 #include "Interfaces/IHttpResponse.h"
@@ -12,10 +18,20 @@
 #include "Misc/Guid.h"
 #include "Misc/FileHelper.h"
 #include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/CityHash.h"
 #include "Containers/Ticker.h"
+#include <atomic>
 
 DEFINE_LOG_CATEGORY_STATIC(LogTokebiAnalytics, Log, All);
 
+// Per-event logging compiles out of shipping builds
+#if UE_BUILD_SHIPPING
+#define TOKEBI_EVENT_LOG(Verbosity, Format, ...)
+#else
+#define TOKEBI_EVENT_LOG(Verbosity, Format, ...) UE_LOG(LogTokebiAnalytics, Verbosity, Format, ##__VA_ARGS__)
+#endif
+
 // Static variables for system state
 bool UTokebiAnalyticsFunctions::bSystemInitialized = false;
 bool UTokebiAnalyticsFunctions::bGameRegistered = false;
@@ -24,16 +40,299 @@ FString UTokebiAnalyticsFunctions::CurrentSessionID = TEXT("");
 // Store the real game_id from registration
 static FString RegisteredGameId = TEXT("");
 
+// A queued event plus the monotonic tick it was tracked at. Wall-clock time is only
+// read once per batch (see FlushQueuedEvents) and events are sent as offsets from it.
+struct FTokebiQueuedEvent
+{
+    TSharedPtr<FJsonObject> Json;
+    int64 Cycles = 0;
+    
+    // Set when identical events were coalesced into this one
+    int32 Count = 1;
+    int64 LastCycles = 0;
+};
+
 // Event queue for batching
-static TArray<TSharedPtr<FJsonObject>> EventQueue;
+static TArray<FTokebiQueuedEvent> EventQueue;
 static FCriticalSection EventQueueLock;
 
+// Per-player contexts (dedicated servers). The default context (0) uses EventQueue above;
+// every other context batches into its own queue and is grouped in the upload envelope.
+struct FTokebiContextState
+{
+    FString PlayerID;
+    FString SessionID;
+    TArray<FTokebiQueuedEvent> Events;
+    bool bPendingRemoval = false; // Destroyed, removed once its queued events are flushed
+};
+
+// One context's share of an outgoing batch
+struct FTokebiContextBatch
+{
+    FString PlayerID;
+    FString SessionID;
+    TArray<FTokebiQueuedEvent> Events;
+};
+
+static TMap<int32, FTokebiContextState> ContextStates; // Guarded by EventQueueLock
+static int32 NextContextId = 1;
+static int32 ContextEventCount = 0;
+
+// Duplicate coalescing, cleared every flush (guarded by EventQueueLock)
+static FTokebiCoalescingTable CoalescingTable;
+static int32 CoalescedEventCount = 0;
+static int64 TotalTrackedEvents = 0;
+static int64 TotalCoalescedEvents = 0;
+
+// Must be called with EventQueueLock held
+static TArray<FTokebiQueuedEvent>* GetContextQueue(int32 ContextId)
+{
+    if (ContextId == 0)
+    {
+        return &EventQueue;
+    }
+    
+    FTokebiContextState* State = ContextStates.Find(ContextId);
+    return State ? &State->Events : nullptr;
+}
+
+static uint64 HashEvent(const FString& EventType, const TMap<FString, FString>& EventData, int32 ContextId)
+{
+    // Pair hashes are summed so the result doesn't depend on map order
+    uint64 PayloadHash = 0;
+    for (const auto& Pair : EventData)
+    {
+        const uint64 KeyHash = CityHash64((const char*)*Pair.Key, Pair.Key.Len() * sizeof(TCHAR));
+        PayloadHash += CityHash64WithSeed((const char*)*Pair.Value, Pair.Value.Len() * sizeof(TCHAR), KeyHash);
+    }
+    return CityHash64WithSeeds((const char*)*EventType, EventType.Len() * sizeof(TCHAR), PayloadHash, (uint64)ContextId);
+}
+
+static bool IsSameEvent(const FTokebiQueuedEvent& Event, const FString& EventType, const TMap<FString, FString>& EventData)
+{
+    if (!Event.Json->GetStringField(TEXT("eventType")).Equals(EventType, ESearchCase::CaseSensitive))
+    {
+        return false;
+    }
+    
+    const TSharedPtr<FJsonObject>& PayloadObject = Event.Json->GetObjectField(TEXT("payload"));
+    if (PayloadObject->Values.Num() != EventData.Num())
+    {
+        return false;
+    }
+    
+    for (const auto& Pair : EventData)
+    {
+        FString Value;
+        if (!PayloadObject->TryGetStringField(Pair.Key, Value) || !Value.Equals(Pair.Value, ESearchCase::CaseSensitive))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Last-sent field hashes for TokebiTrackState, keyed by (context, state name)
+struct FTokebiStateCache
+{
+    TMap<FString, uint64> FieldHashes;
+    int32 DeltasSinceKeyframe = 0;
+    double LastKeyframeTime = 0.0;
+};
+
+static TMap<TPair<int32, FString>, FTokebiStateCache> StateCaches;
+static FCriticalSection StateCacheLock;
+
+// Snapshot vs. sent totals, logged at flush so the savings can be measured
+struct FTokebiStateStats
+{
+    int64 Snapshots = 0;
+    int64 EventsSent = 0;
+    int64 FieldsIn = 0;
+    int64 FieldsSent = 0;
+    int64 BytesIn = 0;
+    int64 BytesSent = 0;
+};
+
+static FTokebiStateStats StateStats; // Guarded by StateCacheLock
+static int64 StateSnapshotsLogged = 0;
+
+static int64 GetFieldBytes(const FString& Key, const FString& Value)
+{
+    return (Key.Len() + Value.Len()) * sizeof(TCHAR);
+}
+
+// Forget what was sent for a context's states, so the next snapshot of each is a keyframe
+static void ResetStateCaches(int32 ContextId)
+{
+    FScopeLock Lock(&StateCacheLock);
+    for (auto It = StateCaches.CreateIterator(); It; ++It)
+    {
+        if (It.Key().Key == ContextId)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+static uint64 HashStateValue(const FString& Value)
+{
+    return CityHash64((const char*)*Value, Value.Len() * sizeof(TCHAR));
+}
+
+// Diffs a snapshot against the last one sent for the state and hands Queue a keyframe (every field)
+// or a delta (changed fields and removed keys). The cache only moves forward once Queue has accepted
+// the event, so later deltas never leave out fields the server didn't get. Returns false if the
+// snapshot was unchanged or the event was dropped.
+//
+// StateCacheLock is held throughout, so snapshots of one state are queued in the order they are diffed.
+// Queue must not flush under it; callers collect the need to flush and do it after releasing the lock.
+static bool TrackStateSnapshot(int32 ContextId, const FString& StateName, const FString& SessionID, const TMap<FString, FString>& StateData,
+                               TFunctionRef<bool(const FString& EventType, const TMap<FString, FString>& Payload, const TSharedPtr<FJsonObject>& EventFields)> Queue)
+{
+    const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
+    const double Now = FPlatformTime::Seconds();
+    
+    FScopeLock Lock(&StateCacheLock);
+    
+    const TPair<int32, FString> CacheKey(ContextId, StateName);
+    const FTokebiStateCache* Cache = StateCaches.Find(CacheKey);
+    
+    // A limit of 0 disables it
+    const bool bKeyframe = !Cache ||
+                           (Settings->StateKeyframeInterval > 0 && Cache->DeltasSinceKeyframe >= Settings->StateKeyframeInterval) ||
+                           (Settings->StateKeyframeSeconds > 0.0f && Now - Cache->LastKeyframeTime >= Settings->StateKeyframeSeconds);
+    
+    TMap<FString, uint64> FieldHashes;
+    FieldHashes.Reserve(StateData.Num());
+    TMap<FString, FString> Payload;
+    int64 SnapshotBytes = 0;
+    
+    // One hash compare per field
+    for (const auto& Pair : StateData)
+    {
+        const uint64 Hash = HashStateValue(Pair.Value);
+        FieldHashes.Add(Pair.Key, Hash);
+        SnapshotBytes += GetFieldBytes(Pair.Key, Pair.Value);
+        
+        const uint64* LastHash = bKeyframe ? nullptr : Cache->FieldHashes.Find(Pair.Key);
+        if (!LastHash || *LastHash != Hash)
+        {
+            Payload.Add(Pair.Key, Pair.Value);
+        }
+    }
+    
+    TArray<TSharedPtr<FJsonValue>> RemovedKeys;
+    int64 RemovedBytes = 0;
+    if (!bKeyframe)
+    {
+        for (const auto& Pair : Cache->FieldHashes)
+        {
+            if (!StateData.Contains(Pair.Key))
+            {
+                RemovedKeys.Add(MakeShareable(new FJsonValueString(Pair.Key)));
+                RemovedBytes += Pair.Key.Len() * sizeof(TCHAR);
+            }
+        }
+    }
+    
+    const bool bUnchanged = !bKeyframe && Payload.Num() == 0 && RemovedKeys.Num() == 0;
+    if (!bUnchanged)
+    {
+        // Bookkeeping goes next to the payload, not in it, so it can't collide with the game's keys
+        TSharedPtr<FJsonObject> EventFields = MakeShareable(new FJsonObject);
+        EventFields->SetStringField(TEXT("stateName"), StateName);
+        if (!SessionID.IsEmpty())
+        {
+            EventFields->SetStringField(TEXT("sessionId"), SessionID);
+        }
+        if (RemovedKeys.Num() > 0)
+        {
+            EventFields->SetArrayField(TEXT("removedKeys"), RemovedKeys);
+        }
+        
+        if (!Queue(bKeyframe ? TEXT("state_keyframe") : TEXT("state_delta"), Payload, EventFields))
+        {
+            return false;
+        }
+        
+        FTokebiStateCache& UpdatedCache = StateCaches.FindOrAdd(CacheKey);
+        UpdatedCache.FieldHashes = MoveTemp(FieldHashes);
+        if (bKeyframe)
+        {
+            UpdatedCache.DeltasSinceKeyframe = 0;
+            UpdatedCache.LastKeyframeTime = Now;
+        }
+        else
+        {
+            UpdatedCache.DeltasSinceKeyframe++;
+        }
+        
+        StateStats.EventsSent++;
+        StateStats.FieldsSent += Payload.Num() + RemovedKeys.Num();
+        StateStats.BytesSent += StateName.Len() * sizeof(TCHAR) + RemovedBytes;
+        for (const auto& Pair : Payload)
+        {
+            StateStats.BytesSent += GetFieldBytes(Pair.Key, Pair.Value);
+        }
+    }
+    
+    StateStats.Snapshots++;
+    StateStats.FieldsIn += StateData.Num();
+    StateStats.BytesIn += StateName.Len() * sizeof(TCHAR) + SnapshotBytes;
+    return !bUnchanged;
+}
+
+static void LogStateTrackingStats()
+{
+    FScopeLock Lock(&StateCacheLock);
+    if (StateStats.Snapshots == StateSnapshotsLogged)
+    {
+        return;
+    }
+    StateSnapshotsLogged = StateStats.Snapshots;
+    
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("State tracking: %lld snapshots sent as %lld events (%.1f%% fewer), %lld of %lld fields, %.1f%% fewer payload bytes"),
+           StateStats.Snapshots, StateStats.EventsSent,
+           100.0 * (StateStats.Snapshots - StateStats.EventsSent) / StateStats.Snapshots,
+           StateStats.FieldsSent, StateStats.FieldsIn,
+           StateStats.BytesIn > 0 ? 100.0 * (StateStats.BytesIn - StateStats.BytesSent) / StateStats.BytesIn : 0.0);
+}
+
+// Ingestion endpoints, picked per batch by health and RTT
+static FTokebiEndpointRouter EndpointRouter;
+
+// Server clock minus local clock in milliseconds, estimated from HTTP Date headers
+static std::atomic<int64> ClockSkewMs(0);
+
+// Skew estimates below this are within the Date header's 1 second resolution
+static const int64 MIN_CLOCK_SKEW_MS = 2000;
+
+static int64 GetUnixTimeMs()
+{
+    return (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+}
+
+static int64 CyclesToMs(int64 Cycles)
+{
+    return (int64)FMath::RoundToDouble((double)Cycles * FPlatformTime::GetSecondsPerCycle64() * 1000.0);
+}
+
+static int64 MsToCycles(int64 Milliseconds)
+{
+    return (int64)FMath::RoundToDouble((double)Milliseconds / (FPlatformTime::GetSecondsPerCycle64() * 1000.0));
+}
+
 // Ticker handle for auto-flush
 static FTSTicker::FDelegateHandle FlushTickerHandle;
 
 // Constants
 static const float FLUSH_INTERVAL = 30.0f; // Flush every 30 seconds
-static const int32 MAX_QUEUE_SIZE = 100;   // Max events before forced flush
+static const int32 MAX_QUEUE_SIZE = 100;   // Max events in the default queue before forced flush
+static const int32 MAX_BATCH_EVENTS = 500; // Max events per upload request; bigger flushes are split
+
+// Identifies a batch across its trace events
+static std::atomic<uint32> NextBatchId(1);
 
 void UTokebiAnalyticsFunctions::TokebiRegisterGame()
 {
@@ -57,9 +356,11 @@ void UTokebiAnalyticsFunctions::TokebiStartSession()
     CurrentSessionID = GenerateSessionID();
     UE_LOG(LogTokebiAnalytics, Log, TEXT("Tokebi session started: %s"), *CurrentSessionID);
     
+    // Each session starts with keyframes so the server can rebuild state within it
+    ResetStateCaches(0);
+    
     TMap<FString, FString> EventData;
     EventData.Add(TEXT("session_id"), CurrentSessionID);
-    EventData.Add(TEXT("timestamp"), FString::FromInt(FDateTime::UtcNow().ToUnixTimestamp()));
     
     QueueEvent(TEXT("session_start"), EventData);
 }
@@ -76,7 +377,6 @@ void UTokebiAnalyticsFunctions::TokebiEndSession()
     
     TMap<FString, FString> EventData;
     EventData.Add(TEXT("session_id"), CurrentSessionID);
-    EventData.Add(TEXT("timestamp"), FString::FromInt(FDateTime::UtcNow().ToUnixTimestamp()));
     
     QueueEvent(TEXT("session_end"), EventData);
     
@@ -90,10 +390,9 @@ void UTokebiAnalyticsFunctions::TokebiTrack(FString EventName, const TMap<FStrin
 {
     InitializeTokebiSystem();
     
-    UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Tracking event: %s"), *EventName);
+    TOKEBI_EVENT_LOG(Verbose, TEXT("Tracking event: %s"), *EventName);
     
     TMap<FString, FString> EnhancedData = EventData;
-    EnhancedData.Add(TEXT("timestamp"), FString::FromInt(FDateTime::UtcNow().ToUnixTimestamp()));
     
     if (!CurrentSessionID.IsEmpty())
     {
@@ -131,12 +430,227 @@ void UTokebiAnalyticsFunctions::TokebiTrackPurchase(FString ItemId, FString Curr
     TokebiTrack(TEXT("item_purchase"), EventData);
 }
 
+void UTokebiAnalyticsFunctions::TokebiTrackState(FString StateName, const TMap<FString, FString>& StateData)
+{
+    TOKEBI_TRACE_SCOPE(Tokebi_TrackState);
+    
+    InitializeTokebiSystem();
+    
+    bool bFlushNeeded = false;
+    const bool bQueued = TrackStateSnapshot(0, StateName, CurrentSessionID, StateData,
+        [&bFlushNeeded](const FString& EventType, const TMap<FString, FString>& Payload, const TSharedPtr<FJsonObject>& EventFields)
+        {
+            // Deltas only add up when applied in order, so they are never coalesced
+            return QueueEvent(EventType, Payload, 0, false, EventFields, &bFlushNeeded);
+        });
+    
+    if (!bQueued)
+    {
+        TOKEBI_EVENT_LOG(Verbose, TEXT("State '%s' unchanged or dropped, nothing sent"), *StateName);
+    }
+    
+    if (bFlushNeeded)
+    {
+        FlushQueuedEvents();
+    }
+}
+
 void UTokebiAnalyticsFunctions::TokebiFlushEvents()
 {
     UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Manual flush requested"));
     FlushQueuedEvents();
 }
 
+FTokebiPlayerContext UTokebiAnalyticsFunctions::TokebiCreatePlayerContext(APlayerController* PlayerController)
+{
+    FString PlayerId;
+    
+    if (PlayerController && PlayerController->PlayerState)
+    {
+        // Prefer the online subsystem ID so the player is recognised across servers
+        const FUniqueNetIdRepl& UniqueId = PlayerController->PlayerState->GetUniqueId();
+        if (UniqueId.IsValid())
+        {
+            PlayerId = UniqueId.ToString();
+        }
+    }
+    
+    if (PlayerId.IsEmpty())
+    {
+        // Same format as GetPlayerID, but not persisted - server contexts are per connection
+        PlayerId = FString::Printf(TEXT("player_%lld_%s"), 
+                                   FDateTime::UtcNow().ToUnixTimestamp(),
+                                   *FGuid::NewGuid().ToString(EGuidFormats::Digits).Right(8));
+    }
+    
+    return TokebiCreatePlayerContextWithID(PlayerId);
+}
+
+FTokebiPlayerContext UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(FString PlayerId)
+{
+    InitializeTokebiSystem();
+    
+    FTokebiPlayerContext Context;
+    if (PlayerId.IsEmpty())
+    {
+        UE_LOG(LogTokebiAnalytics, Warning, TEXT("Cannot create player context without a player ID"));
+        return Context;
+    }
+    
+    {
+        FScopeLock Lock(&EventQueueLock);
+        Context.ContextId = NextContextId++;
+        FTokebiContextState& State = ContextStates.Add(Context.ContextId);
+        State.PlayerID = PlayerId;
+    }
+    
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Created player context %d for player: %s"), Context.ContextId, *PlayerId);
+    return Context;
+}
+
+void UTokebiAnalyticsFunctions::TokebiDestroyPlayerContext(FTokebiPlayerContext Context)
+{
+    if (!Context.IsValid())
+    {
+        return;
+    }
+    
+    TokebiEndContextSession(Context);
+    
+    {
+        FScopeLock Lock(&EventQueueLock);
+        if (FTokebiContextState* State = ContextStates.Find(Context.ContextId))
+        {
+            // Keep the context around until its queued events have gone out with the next flush
+            if (State->Events.Num() > 0)
+            {
+                State->bPendingRemoval = true;
+            }
+            else
+            {
+                ContextStates.Remove(Context.ContextId);
+            }
+            
+            UE_LOG(LogTokebiAnalytics, Log, TEXT("Destroyed player context %d"), Context.ContextId);
+        }
+    }
+    
+    // After the context is gone, so state tracking can't recreate a cache for it
+    ResetStateCaches(Context.ContextId);
+}
+
+void UTokebiAnalyticsFunctions::TokebiStartContextSession(FTokebiPlayerContext Context)
+{
+    FString SessionID = GenerateSessionID();
+    {
+        FScopeLock Lock(&EventQueueLock);
+        FTokebiContextState* State = ContextStates.Find(Context.ContextId);
+        if (!State || State->bPendingRemoval)
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Cannot start session - invalid player context %d"), Context.ContextId);
+            return;
+        }
+        State->SessionID = SessionID;
+    }
+    
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Tokebi session started for context %d: %s"), Context.ContextId, *SessionID);
+    
+    ResetStateCaches(Context.ContextId);
+    
+    TMap<FString, FString> EventData;
+    EventData.Add(TEXT("session_id"), SessionID);
+    
+    QueueEvent(TEXT("session_start"), EventData, Context.ContextId);
+}
+
+void UTokebiAnalyticsFunctions::TokebiEndContextSession(FTokebiPlayerContext Context)
+{
+    FString SessionID;
+    {
+        FScopeLock Lock(&EventQueueLock);
+        FTokebiContextState* State = ContextStates.Find(Context.ContextId);
+        if (!State || State->SessionID.IsEmpty())
+        {
+            return;
+        }
+        SessionID = State->SessionID;
+    }
+    
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Tokebi session ended for context %d: %s"), Context.ContextId, *SessionID);
+    
+    TMap<FString, FString> EventData;
+    EventData.Add(TEXT("session_id"), SessionID);
+    
+    // No immediate flush here - on a server the shared ticker picks it up with everyone else's events
+    QueueEvent(TEXT("session_end"), EventData, Context.ContextId);
+    
+    FScopeLock Lock(&EventQueueLock);
+    if (FTokebiContextState* State = ContextStates.Find(Context.ContextId))
+    {
+        State->SessionID.Empty();
+    }
+}
+
+void UTokebiAnalyticsFunctions::TokebiTrackForContext(FTokebiPlayerContext Context, FString EventName, const TMap<FString, FString>& EventData)
+{
+    TOKEBI_EVENT_LOG(Verbose, TEXT("Tracking event for context %d: %s"), Context.ContextId, *EventName);
+    
+    TMap<FString, FString> EnhancedData = EventData;
+    
+    {
+        FScopeLock Lock(&EventQueueLock);
+        const FTokebiContextState* State = ContextStates.Find(Context.ContextId);
+        if (!State || State->bPendingRemoval)
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Dropping event '%s' - invalid player context %d"), *EventName, Context.ContextId);
+            return;
+        }
+        
+        if (!State->SessionID.IsEmpty())
+        {
+            EnhancedData.Add(TEXT("session_id"), State->SessionID);
+        }
+    }
+    
+    QueueEvent(EventName, EnhancedData, Context.ContextId);
+}
+
+void UTokebiAnalyticsFunctions::TokebiTrackStateForContext(FTokebiPlayerContext Context, FString StateName, const TMap<FString, FString>& StateData)
+{
+    TOKEBI_TRACE_SCOPE(Tokebi_TrackState);
+    
+    bool bFlushNeeded = false;
+    {
+        // Held from the check to the cache update, so a context destroyed meanwhile has its caches
+        // cleared after this snapshot instead of having one recreated for it
+        FScopeLock StateLock(&StateCacheLock);
+        
+        FString SessionID;
+        {
+            FScopeLock Lock(&EventQueueLock);
+            const FTokebiContextState* State = ContextStates.Find(Context.ContextId);
+            if (!State || State->bPendingRemoval)
+            {
+                UE_LOG(LogTokebiAnalytics, Warning, TEXT("Dropping state '%s' - invalid player context %d"), *StateName, Context.ContextId);
+                return;
+            }
+            SessionID = State->SessionID;
+        }
+        
+        TrackStateSnapshot(Context.ContextId, StateName, SessionID, StateData,
+            [&Context, &bFlushNeeded](const FString& EventType, const TMap<FString, FString>& Payload, const TSharedPtr<FJsonObject>& EventFields)
+            {
+                return QueueEvent(EventType, Payload, Context.ContextId, false, EventFields, &bFlushNeeded);
+            });
+    }
+    
+    // Sending the batch waits until the state cache is free again
+    if (bFlushNeeded)
+    {
+        FlushQueuedEvents();
+    }
+}
+
 void UTokebiAnalyticsFunctions::InitializeTokebiSystem()
 {
     if (bSystemInitialized)
@@ -144,6 +658,8 @@ void UTokebiAnalyticsFunctions::InitializeTokebiSystem()
         return;
     }
     
+    TOKEBI_TRACE_SCOPE(Tokebi_InitializeTokebiSystem);
+    
     UE_LOG(LogTokebiAnalytics, Log, TEXT("Initializing Tokebi Analytics system"));
     
     // Load any offline events from previous session
@@ -152,6 +668,9 @@ void UTokebiAnalyticsFunctions::InitializeTokebiSystem()
     // Start auto-flush using global ticker
     StartFlushTicker();
     
+    ConfigureEndpointRouter();
+    EndpointRouter.StartProbing();
+    
     // 🔧 IMPROVED: If we loaded saved events, flush them immediately
     // Don't wait for the 30-second timer
     {
@@ -173,14 +692,59 @@ void UTokebiAnalyticsFunctions::InitializeTokebiSystem()
     bSystemInitialized = true;
 }
 
-void UTokebiAnalyticsFunctions::QueueEvent(const FString& EventType, const TMap<FString, FString>& EventData)
+void UTokebiAnalyticsFunctions::ShutdownTokebiSystem()
+{
+    // Both tickers call into this module, so they can't outlive it
+    StopFlushTicker();
+    EndpointRouter.StopProbing();
+    bSystemInitialized = false;
+}
+
+bool UTokebiAnalyticsFunctions::QueueEvent(const FString& EventType, const TMap<FString, FString>& EventData, int32 ContextId, bool bAllowCoalesce, const TSharedPtr<FJsonObject>& EventFields,
+                                           bool* OutFlushNeeded)
 {
+    TOKEBI_TRACE_SCOPE(Tokebi_QueueEvent);
+    
+    // Capture the tick first so the event's time doesn't include the work below
+    const int64 EnqueueCycles = (int64)FPlatformTime::Cycles64();
+    
     const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
     
     if (!Settings || Settings->TokebiApiKey.IsEmpty() || Settings->TokebiGameId.IsEmpty())
     {
         UE_LOG(LogTokebiAnalytics, Error, TEXT("Tokebi Analytics not configured! Please set API Key and Game ID in Project Settings"));
-        return;
+        return false;
+    }
+    
+    // Opt-in coalescing: an identical event queued within the window just has its count bumped,
+    // so we skip building the JSON entirely
+    const bool bCoalesce = bAllowCoalesce && Settings->bCoalesceDuplicateEvents;
+    uint64 CoalesceHash = 0;
+    if (bCoalesce)
+    {
+        CoalesceHash = HashEvent(EventType, EventData, ContextId);
+        
+        FScopeLock Lock(&EventQueueLock);
+        TotalTrackedEvents++;
+        
+        TArray<FTokebiQueuedEvent>* Queue = GetContextQueue(ContextId);
+        int32* ExistingIndex = Queue ? CoalescingTable.Find(CoalesceHash, ContextId, [Queue, &EventType, &EventData](int32 Index)
+        {
+            return IsSameEvent((*Queue)[Index], EventType, EventData);
+        }) : nullptr;
+        
+        if (ExistingIndex)
+        {
+            FTokebiQueuedEvent& Existing = (*Queue)[*ExistingIndex];
+            if (CyclesToMs(EnqueueCycles - Existing.Cycles) <= (int64)(Settings->CoalesceWindowSeconds * 1000.0f))
+            {
+                Existing.Count++;
+                Existing.LastCycles = EnqueueCycles;
+                CoalescedEventCount++;
+                TotalCoalescedEvents++;
+                return true;
+            }
+        }
     }
     
     // Use the real game_id if available, fallback to settings
@@ -190,10 +754,22 @@ void UTokebiAnalyticsFunctions::QueueEvent(const FString& EventType, const TMap<
     TSharedPtr<FJsonObject> EventObject = MakeShareable(new FJsonObject);
     EventObject->SetStringField(TEXT("eventType"), EventType);
     EventObject->SetStringField(TEXT("gameId"), GameIdToUse);
-    EventObject->SetStringField(TEXT("playerId"), GetPlayerID());
+    if (ContextId == 0)
+    {
+        // Context events get their playerId from the context group in the envelope
+        EventObject->SetStringField(TEXT("playerId"), GetPlayerID());
+    }
     EventObject->SetStringField(TEXT("platform"), TEXT("unreal"));
     EventObject->SetStringField(TEXT("environment"), Settings->TokebiEnvironment);
     
+    if (EventFields.IsValid())
+    {
+        for (const auto& Field : EventFields->Values)
+        {
+            EventObject->SetField(Field.Key, Field.Value);
+        }
+    }
+    
     // Add payload
     TSharedPtr<FJsonObject> PayloadObject = MakeShareable(new FJsonObject);
     for (const auto& Pair : EventData)
@@ -203,32 +779,85 @@ void UTokebiAnalyticsFunctions::QueueEvent(const FString& EventType, const TMap<
     EventObject->SetObjectField(TEXT("payload"), PayloadObject);
     
     // Debug log - Show which game ID we're using
-    UE_LOG(LogTokebiAnalytics, Log, TEXT("🔧 Event '%s' using gameId: %s"), *EventType, *GameIdToUse);
+    TOKEBI_EVENT_LOG(Verbose, TEXT("🔧 Event '%s' using gameId: %s"), *EventType, *GameIdToUse);
+    
+    FTokebiQueuedEvent QueuedEvent;
+    QueuedEvent.Json = EventObject;
+    QueuedEvent.Cycles = EnqueueCycles;
     
     // Add to queue (thread-safe)
+    bool bForceFlush = false;
     {
         FScopeLock Lock(&EventQueueLock);
-        EventQueue.Add(EventObject);
+        TArray<FTokebiQueuedEvent>* Queue = GetContextQueue(ContextId);
+        if (!Queue)
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Dropping event '%s' - player context %d no longer exists"), *EventType, ContextId);
+            return false;
+        }
+        
+        const int32 EventIndex = Queue->Add(MoveTemp(QueuedEvent));
+        if (ContextId != 0)
+        {
+            ContextEventCount++;
+        }
         
-        UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Queued event: %s (Queue size: %d)"), *EventType, EventQueue.Num());
+        if (bCoalesce)
+        {
+            // Later duplicates merge into this event. If an older copy is in the table its window
+            // has passed, so point the entry here instead.
+            int32* ExistingIndex = CoalescingTable.Find(CoalesceHash, ContextId, [Queue, EventIndex, &EventType, &EventData](int32 Index)
+            {
+                return Index != EventIndex && IsSameEvent((*Queue)[Index], EventType, EventData);
+            });
+            
+            if (ExistingIndex)
+            {
+                *ExistingIndex = EventIndex;
+            }
+            else
+            {
+                CoalescingTable.Add(CoalesceHash, ContextId, EventIndex);
+            }
+        }
         
-        // Force flush if queue is getting large
-        if (EventQueue.Num() >= MAX_QUEUE_SIZE)
+        const int32 QueueSize = EventQueue.Num() + ContextEventCount;
+        TOKEBI_EVENT_LOG(Verbose, TEXT("Queued event: %s (Queue size: %d)"), *EventType, QueueSize);
+        
+        // Force flush if queue is getting large. Context queues share one limit of a full batch,
+        // so the work a tracking call can trigger stays the same however many players there are.
+        bForceFlush = EventQueue.Num() >= MAX_QUEUE_SIZE || ContextEventCount >= MAX_BATCH_EVENTS;
+    }
+    
+    // Serializing and sending the batch happens outside the lock so other threads can keep tracking
+    if (bForceFlush)
+    {
+        UE_LOG(LogTokebiAnalytics, Warning, TEXT("Event queue full, forcing flush"));
+        if (OutFlushNeeded)
+        {
+            *OutFlushNeeded = true;
+        }
+        else
         {
-            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Event queue full, forcing flush"));
             FlushQueuedEvents();
         }
     }
+    return true;
 }
 
 void UTokebiAnalyticsFunctions::FlushQueuedEvents()
 {
-    TArray<TSharedPtr<FJsonObject>> EventsToSend;
+    TOKEBI_TRACE_SCOPE(Tokebi_FlushQueuedEvents);
+    
+    TArray<FTokebiQueuedEvent> EventsToSend;
+    TArray<FTokebiContextBatch> ContextBatches;
+    int32 TotalEvents = 0;
+    int32 CoalescedEvents = 0;
     
     // Get events from queue (thread-safe)
     {
         FScopeLock Lock(&EventQueueLock);
-        if (EventQueue.Num() == 0)
+        if (EventQueue.Num() == 0 && ContextEventCount == 0)
         {
             UE_LOG(LogTokebiAnalytics, Verbose, TEXT("No events to flush"));
             return;
@@ -236,9 +865,43 @@ void UTokebiAnalyticsFunctions::FlushQueuedEvents()
         
         EventsToSend = EventQueue;
         EventQueue.Empty();
+        TotalEvents = EventsToSend.Num() + ContextEventCount;
+        
+        for (auto It = ContextStates.CreateIterator(); It; ++It)
+        {
+            FTokebiContextState& State = It.Value();
+            if (State.Events.Num() > 0)
+            {
+                FTokebiContextBatch& Batch = ContextBatches.AddDefaulted_GetRef();
+                Batch.PlayerID = State.PlayerID;
+                Batch.SessionID = State.SessionID;
+                Batch.Events = MoveTemp(State.Events);
+                State.Events.Reset();
+            }
+            
+            if (State.bPendingRemoval)
+            {
+                It.RemoveCurrent();
+            }
+        }
+        ContextEventCount = 0;
+        
+        CoalescingTable.Reset();
+        CoalescedEvents = CoalescedEventCount;
+        CoalescedEventCount = 0;
     }
     
-    UE_LOG(LogTokebiAnalytics, Log, TEXT("Flushing %d events to Tokebi"), EventsToSend.Num());
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Flushing %d events to Tokebi (%d player contexts)"), TotalEvents, ContextBatches.Num());
+    
+    LogStateTrackingStats();
+    
+    if (CoalescedEvents > 0)
+    {
+        UE_LOG(LogTokebiAnalytics, Log, TEXT("Coalesced %d tracked events into %d (%.1f%% reduction, %.1f%% overall)"),
+               TotalEvents + CoalescedEvents, TotalEvents,
+               100.0 * CoalescedEvents / (TotalEvents + CoalescedEvents),
+               100.0 * TotalCoalescedEvents / FMath::Max<int64>(TotalTrackedEvents, 1));
+    }
     
     const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
     if (!Settings)
@@ -247,43 +910,171 @@ void UTokebiAnalyticsFunctions::FlushQueuedEvents()
         return;
     }
     
-    // Create batch payload
-    TSharedPtr<FJsonObject> BatchObject = MakeShareable(new FJsonObject);
-    TArray<TSharedPtr<FJsonValue>> EventsArray;
+    // Anchor the batch to a single wall-clock reading; each event carries its
+    // millisecond offset from it, taken from the monotonic tick captured at enqueue
+    const int64 AnchorCycles = (int64)FPlatformTime::Cycles64();
+    const int64 SkewMs = Settings->bCorrectClockSkew ? ClockSkewMs.load() : 0;
+    const int64 SentAtMs = GetUnixTimeMs() + SkewMs;
     
-    for (const auto& Event : EventsToSend)
+    auto MakeEventValue = [AnchorCycles](const FTokebiQueuedEvent& Event) -> TSharedPtr<FJsonValue>
     {
-        EventsArray.Add(MakeShareable(new FJsonValueObject(Event)));
-    }
-    
-    BatchObject->SetArrayField(TEXT("events"), EventsArray);
-    
-    // Serialize to string
-    FString JsonString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
-    FJsonSerializer::Serialize(BatchObject.ToSharedRef(), Writer);
+        Event.Json->SetNumberField(TEXT("timeOffsetMs"), (double)CyclesToMs(Event.Cycles - AnchorCycles));
+        if (Event.Count > 1)
+        {
+            Event.Json->SetNumberField(TEXT("count"), Event.Count);
+            Event.Json->SetNumberField(TEXT("lastTimeOffsetMs"), (double)CyclesToMs(Event.LastCycles - AnchorCycles));
+        }
+        return MakeShareable(new FJsonValueObject(Event.Json));
+    };
     
-    // Use correct track endpoint
-    FString TrackEndpoint = Settings->TokebiEndpoint + TEXT("/api/track");
+    // Serializes and sends one request's worth of events
+    auto SendEnvelope = [&MakeEventValue, SentAtMs, SkewMs](const TArray<FTokebiQueuedEvent>& EnvelopeEvents, const TArray<FTokebiContextBatch>& EnvelopeContexts, int32 EnvelopeSize)
+    {
+        // Create batch payload
+        TSharedPtr<FJsonObject> BatchObject = MakeShareable(new FJsonObject);
+        TArray<TSharedPtr<FJsonValue>> EventsArray;
+        
+        for (const auto& Event : EnvelopeEvents)
+        {
+            EventsArray.Add(MakeEventValue(Event));
+        }
+        
+        BatchObject->SetNumberField(TEXT("sentAt"), (double)SentAtMs);
+        BatchObject->SetArrayField(TEXT("events"), EventsArray);
+        
+        // Context events are grouped per player so playerId/sessionId are sent once per group
+        if (EnvelopeContexts.Num() > 0)
+        {
+            TArray<TSharedPtr<FJsonValue>> ContextsArray;
+            for (const FTokebiContextBatch& Batch : EnvelopeContexts)
+            {
+                TArray<TSharedPtr<FJsonValue>> ContextEventsArray;
+                for (const auto& Event : Batch.Events)
+                {
+                    ContextEventsArray.Add(MakeEventValue(Event));
+                }
+                
+                TSharedPtr<FJsonObject> ContextObject = MakeShareable(new FJsonObject);
+                ContextObject->SetStringField(TEXT("playerId"), Batch.PlayerID);
+                if (!Batch.SessionID.IsEmpty())
+                {
+                    ContextObject->SetStringField(TEXT("sessionId"), Batch.SessionID);
+                }
+                ContextObject->SetArrayField(TEXT("events"), ContextEventsArray);
+                ContextsArray.Add(MakeShareable(new FJsonValueObject(ContextObject)));
+            }
+            BatchObject->SetArrayField(TEXT("contexts"), ContextsArray);
+        }
+        
+        // Serialize to string
+        FString JsonString;
+        {
+            TOKEBI_TRACE_SCOPE(Tokebi_SerializeBatch);
+            TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+            FJsonSerializer::Serialize(BatchObject.ToSharedRef(), Writer);
+        }
+        
+        const uint32 BatchId = NextBatchId++;
+        TOKEBI_TRACE_BATCH_CREATED(BatchId, EnvelopeSize, EnvelopeContexts.Num(), JsonString.Len());
+        
+        UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Payload: %s"), *JsonString);
+        
+        SendTrackRequest(BatchId, JsonString, [EnvelopeEvents, EnvelopeContexts, EnvelopeSize, SentAtMs, SkewMs](bool bSuccess, int32 ResponseCode, FString ResponseBody)
+        {
+            TOKEBI_TRACE_SCOPE(Tokebi_OnBatchComplete);
+            
+            if (bSuccess && EHttpResponseCodes::IsOk(ResponseCode))
+            {
+                UE_LOG(LogTokebiAnalytics, Log, TEXT("✅ Successfully sent batch of %d events"), EnvelopeSize);
+            }
+            else
+            {
+                UE_LOG(LogTokebiAnalytics, Warning, TEXT("❌ Failed to send events batch, response code: %d"), ResponseCode);
+                UE_LOG(LogTokebiAnalytics, Warning, TEXT("Response body: %s"), *ResponseBody);
+                
+                // Ticks don't survive a restart, so saved events get an absolute timestamp. It's device
+                // time, like the clock LoadEventsFromFile rebases it against; the skew correction is
+                // applied again when the event is next sent.
+                const int64 LocalSentAtMs = SentAtMs - SkewMs;
+                TArray<TSharedPtr<FJsonObject>> EventsToSave;
+                auto AddEventToSave = [&EventsToSave, LocalSentAtMs](const FTokebiQueuedEvent& Event)
+                {
+                    Event.Json->SetNumberField(TEXT("timestamp"), (double)(LocalSentAtMs + (int64)Event.Json->GetNumberField(TEXT("timeOffsetMs"))));
+                    Event.Json->RemoveField(TEXT("timeOffsetMs"));
+                    if (Event.Count > 1)
+                    {
+                        Event.Json->SetNumberField(TEXT("lastTimestamp"), (double)(LocalSentAtMs + (int64)Event.Json->GetNumberField(TEXT("lastTimeOffsetMs"))));
+                        Event.Json->RemoveField(TEXT("lastTimeOffsetMs"));
+                    }
+                    EventsToSave.Add(Event.Json);
+                };
+                
+                for (const auto& Event : EnvelopeEvents)
+                {
+                    AddEventToSave(Event);
+                }
+                
+                // The offline file stores flat events, so stamp each context event with its player
+                for (const FTokebiContextBatch& Batch : EnvelopeContexts)
+                {
+                    for (const auto& Event : Batch.Events)
+                    {
+                        Event.Json->SetStringField(TEXT("playerId"), Batch.PlayerID);
+                        AddEventToSave(Event);
+                    }
+                }
+                
+                // Save failed events to file for retry
+                SaveEventsToFile(EventsToSave);
+            }
+        });
+    };
     
-    UE_LOG(LogTokebiAnalytics, Log, TEXT("Sending to endpoint: %s"), *TrackEndpoint);
-    UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Payload: %s"), *JsonString);
+    // Split into requests of at most MAX_BATCH_EVENTS, so neither the request nor the time spent
+    // serializing it grows with the number of players. A context's events may span two requests.
+    TArray<FTokebiQueuedEvent> EnvelopeEvents;
+    TArray<FTokebiContextBatch> EnvelopeContexts;
+    int32 EnvelopeSize = 0;
     
-    SendHTTPRequest(TrackEndpoint, JsonString, [EventsToSend](bool bSuccess, int32 ResponseCode, FString ResponseBody)
+    for (int32 Start = 0; Start < EventsToSend.Num(); Start += MAX_BATCH_EVENTS)
     {
-        if (bSuccess && ResponseCode == 200)
+        const int32 Count = FMath::Min(EventsToSend.Num() - Start, MAX_BATCH_EVENTS);
+        EnvelopeEvents.Append(EventsToSend.GetData() + Start, Count);
+        EnvelopeSize = Count;
+        if (EnvelopeSize == MAX_BATCH_EVENTS)
         {
-            UE_LOG(LogTokebiAnalytics, Log, TEXT("✅ Successfully sent batch of %d events"), EventsToSend.Num());
+            SendEnvelope(EnvelopeEvents, EnvelopeContexts, EnvelopeSize);
+            EnvelopeEvents.Reset();
+            EnvelopeSize = 0;
         }
-        else
+    }
+    
+    for (const FTokebiContextBatch& Batch : ContextBatches)
+    {
+        for (int32 Start = 0; Start < Batch.Events.Num(); )
         {
-            UE_LOG(LogTokebiAnalytics, Warning, TEXT("❌ Failed to send events batch, response code: %d"), ResponseCode);
-            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Response body: %s"), *ResponseBody);
+            const int32 Count = FMath::Min(Batch.Events.Num() - Start, MAX_BATCH_EVENTS - EnvelopeSize);
+            FTokebiContextBatch& Part = EnvelopeContexts.AddDefaulted_GetRef();
+            Part.PlayerID = Batch.PlayerID;
+            Part.SessionID = Batch.SessionID;
+            Part.Events.Append(Batch.Events.GetData() + Start, Count);
+            Start += Count;
+            EnvelopeSize += Count;
             
-            // Save failed events to file for retry
-            SaveEventsToFile(EventsToSend);
+            if (EnvelopeSize == MAX_BATCH_EVENTS)
+            {
+                SendEnvelope(EnvelopeEvents, EnvelopeContexts, EnvelopeSize);
+                EnvelopeEvents.Reset();
+                EnvelopeContexts.Reset();
+                EnvelopeSize = 0;
+            }
         }
-    });
+    }
+    
+    if (EnvelopeSize > 0)
+    {
+        SendEnvelope(EnvelopeEvents, EnvelopeContexts, EnvelopeSize);
+    }
 }
 
 void UTokebiAnalyticsFunctions::RegisterGameWithTokebi()
@@ -365,8 +1156,84 @@ void UTokebiAnalyticsFunctions::OnGameRegistrationComplete(bool bSuccess)
     }
 }
 
+void UTokebiAnalyticsFunctions::ConfigureEndpointRouter()
+{
+    const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
+    if (!Settings)
+    {
+        return;
+    }
+    
+    // The primary endpoint is always a candidate
+    TArray<FString> BaseUrls;
+    BaseUrls.Add(Settings->TokebiEndpoint);
+    BaseUrls.Append(Settings->TokebiIngestionEndpoints);
+    
+    EndpointRouter.Configure(BaseUrls, Settings->EndpointProbeInterval, Settings->TokebiApiKey);
+}
+
+void UTokebiAnalyticsFunctions::SendTrackRequest(uint32 BatchId, const FString& JsonPayload, TFunction<void(bool, int32, FString)> Callback, TSet<int32> TriedEndpoints)
+{
+    if (EndpointRouter.Num() == 0)
+    {
+        ConfigureEndpointRouter();
+    }
+    
+    const int32 EndpointIndex = EndpointRouter.SelectEndpoint(TriedEndpoints);
+    if (EndpointIndex == INDEX_NONE)
+    {
+        Callback(false, 0, TEXT("No ingestion endpoint configured"));
+        return;
+    }
+    TriedEndpoints.Add(EndpointIndex);
+    
+    // Use correct track endpoint
+    FString TrackEndpoint = EndpointRouter.GetBaseUrl(EndpointIndex) + TEXT("/api/track");
+    
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Sending to endpoint: %s"), *TrackEndpoint);
+    TOKEBI_TRACE_BATCH_SENT(BatchId, TriedEndpoints.Num(), JsonPayload.Len(), TrackEndpoint);
+    
+    const double StartTime = FPlatformTime::Seconds();
+    SendHTTPRequest(TrackEndpoint, JsonPayload, [BatchId, JsonPayload, Callback, TriedEndpoints, EndpointIndex, StartTime](bool bSuccess, int32 ResponseCode, FString ResponseBody)
+    {
+        // Only an accepted batch says anything good about the endpoint
+        if (bSuccess && EHttpResponseCodes::IsOk(ResponseCode))
+        {
+            const double LatencyMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+            TOKEBI_TRACE_BATCH_ACKED(BatchId, ResponseCode, LatencyMs);
+            EndpointRouter.ReportSuccess(EndpointIndex, LatencyMs);
+            Callback(bSuccess, ResponseCode, ResponseBody);
+            return;
+        }
+        
+        // A rejected API key or payload would fail the same way on every endpoint. Anything else - network
+        // errors, a 404 from a misconfigured URL, timeouts, rate limits, server errors - is this endpoint's fault.
+        if (bSuccess && (ResponseCode == EHttpResponseCodes::BadRequest || ResponseCode == EHttpResponseCodes::Denied ||
+                         ResponseCode == EHttpResponseCodes::Forbidden || ResponseCode == EHttpResponseCodes::RequestTooLarge ||
+                         ResponseCode == 422)) // Unprocessable entity, not in EHttpResponseCodes
+        {
+            Callback(bSuccess, ResponseCode, ResponseBody);
+            return;
+        }
+        
+        EndpointRouter.ReportFailure(EndpointIndex);
+        
+        if (TriedEndpoints.Num() < EndpointRouter.Num())
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Failing over to next endpoint (%d of %d tried)"), TriedEndpoints.Num(), EndpointRouter.Num());
+            TOKEBI_TRACE_BATCH_RETRIED(BatchId, TriedEndpoints.Num() + 1, ResponseCode);
+            SendTrackRequest(BatchId, JsonPayload, Callback, TriedEndpoints);
+            return;
+        }
+        
+        Callback(bSuccess, ResponseCode, ResponseBody);
+    });
+}
+
 void UTokebiAnalyticsFunctions::SendHTTPRequest(const FString& Endpoint, const FString& JsonPayload, TFunction<void(bool, int32, FString)> Callback)
 {
+    TOKEBI_TRACE_SCOPE(Tokebi_SendHTTPRequest);
+    
     const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
     if (!Settings)
     {
@@ -387,14 +1254,29 @@ void UTokebiAnalyticsFunctions::SendHTTPRequest(const FString& Endpoint, const F
     UE_LOG(LogTokebiAnalytics, Verbose, TEXT("HTTP Request API Key: %s"), *Settings->TokebiApiKey);
     UE_LOG(LogTokebiAnalytics, VeryVerbose, TEXT("HTTP Request Body: %s"), *JsonPayload);
     
+    const int64 RequestSentMs = GetUnixTimeMs();
+    
     // Set completion callback
-    HttpRequest->OnProcessRequestComplete().BindLambda([Callback, Endpoint](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+    HttpRequest->OnProcessRequestComplete().BindLambda([Callback, Endpoint, RequestSentMs](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
     {
         if (bWasSuccessful && Response.IsValid())
         {
             int32 ResponseCode = Response->GetResponseCode();
             FString ResponseBody = Response->GetContentAsString();
             
+            // Estimate device clock skew from the server's Date header. The header is truncated
+            // to whole seconds, so compare its midpoint against the midpoint of the round trip.
+            FDateTime ServerTime;
+            if (FDateTime::ParseHttpDate(Response->GetHeader(TEXT("Date")), ServerTime))
+            {
+                const int64 ServerMs = (ServerTime - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond + 500;
+                const int64 LocalMs = (RequestSentMs + GetUnixTimeMs()) / 2;
+                const int64 SkewMs = ServerMs - LocalMs;
+                
+                ClockSkewMs = FMath::Abs(SkewMs) >= MIN_CLOCK_SKEW_MS ? SkewMs : 0;
+                UE_LOG(LogTokebiAnalytics, VeryVerbose, TEXT("Estimated clock skew: %lld ms"), SkewMs);
+            }
+            
             UE_LOG(LogTokebiAnalytics, Verbose, TEXT("HTTP Response [%s] Code: %d"), *Endpoint, ResponseCode);
             if (ResponseCode != 200 && ResponseCode != 201)
             {
@@ -420,6 +1302,8 @@ void UTokebiAnalyticsFunctions::SendHTTPRequest(const FString& Endpoint, const F
 
 void UTokebiAnalyticsFunctions::SaveEventsToFile(const TArray<TSharedPtr<FJsonObject>>& Events)
 {
+    TOKEBI_TRACE_SCOPE(Tokebi_SaveEventsToFile);
+    
     if (Events.Num() == 0)
     {
         UE_LOG(LogTokebiAnalytics, Verbose, TEXT("No events to save"));
@@ -493,6 +1377,7 @@ void UTokebiAnalyticsFunctions::SaveEventsToFile(const TArray<TSharedPtr<FJsonOb
     // Save to file
     if (FFileHelper::SaveStringToFile(JsonString, *FilePath))
     {
+        TOKEBI_TRACE_EVENTS_SPILLED(Events.Num(), JsonString.Len());
         UE_LOG(LogTokebiAnalytics, Log, TEXT("✅ Saved %d failed events to file (total: %d)"), 
                Events.Num(), AllEvents.Num());
     }
@@ -504,6 +1389,8 @@ void UTokebiAnalyticsFunctions::SaveEventsToFile(const TArray<TSharedPtr<FJsonOb
 
 void UTokebiAnalyticsFunctions::LoadEventsFromFile()
 {
+    TOKEBI_TRACE_SCOPE(Tokebi_LoadEventsFromFile);
+    
     FString FilePath = GetOfflineEventsPath();
     FString SavedJson;
     
@@ -526,6 +1413,10 @@ void UTokebiAnalyticsFunctions::LoadEventsFromFile()
         int32 EventsLoaded = 0;
         int32 EventsFixed = 0;
         
+        // Rebase saved absolute timestamps onto the monotonic clock
+        const int64 NowCycles = (int64)FPlatformTime::Cycles64();
+        const int64 NowMs = GetUnixTimeMs();
+        
         {
             FScopeLock Lock(&EventQueueLock);
             for (const auto& EventValue : SavedEventsArray)
@@ -550,7 +1441,28 @@ void UTokebiAnalyticsFunctions::LoadEventsFromFile()
                         }
                     }
                     
-                    EventQueue.Add(EventObj);
+                    FTokebiQueuedEvent& QueuedEvent = EventQueue.AddDefaulted_GetRef();
+                    QueuedEvent.Json = EventObj;
+                    QueuedEvent.Cycles = NowCycles;
+                    
+                    double TimestampMs = 0.0;
+                    if (EventObj->TryGetNumberField(TEXT("timestamp"), TimestampMs))
+                    {
+                        QueuedEvent.Cycles = NowCycles - MsToCycles(NowMs - (int64)TimestampMs);
+                        EventObj->RemoveField(TEXT("timestamp"));
+                    }
+                    
+                    // Coalesced events keep their count and last occurrence
+                    double LastTimestampMs = 0.0;
+                    int32 Count = 1;
+                    if (EventObj->TryGetNumberField(TEXT("count"), Count) && EventObj->TryGetNumberField(TEXT("lastTimestamp"), LastTimestampMs))
+                    {
+                        QueuedEvent.Count = Count;
+                        QueuedEvent.LastCycles = NowCycles - MsToCycles(NowMs - (int64)LastTimestampMs);
+                        EventObj->RemoveField(TEXT("count"));
+                        EventObj->RemoveField(TEXT("lastTimestamp"));
+                    }
+                    
                     EventsLoaded++;
                 }
             }
@@ -649,4 +1561,81 @@ FString UTokebiAnalyticsFunctions::GenerateSessionID()
     return FString::Printf(TEXT("session_%lld_%s"), 
                           FDateTime::UtcNow().ToUnixTimestamp(),
                           *FGuid::NewGuid().ToString(EGuidFormats::Digits).Right(8));
-}
\ No newline at end of file
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+void FTokebiAnalyticsTestAccess::ResetPipeline()
+{
+    {
+        FScopeLock Lock(&EventQueueLock);
+        EventQueue.Empty();
+        ContextStates.Empty();
+        ContextEventCount = 0;
+        CoalescingTable.Reset();
+        CoalescedEventCount = 0;
+    }
+    
+    ClockSkewMs = 0;
+    
+    {
+        FScopeLock Lock(&StateCacheLock);
+        StateCaches.Empty();
+        StateStats = FTokebiStateStats();
+        StateSnapshotsLogged = 0;
+    }
+    
+    // Forget health and RTTs measured by earlier tests, then probe the new endpoints right away
+    EndpointRouter.Configure(TArray<FString>(), 60.0f, FString());
+    UTokebiAnalyticsFunctions::ConfigureEndpointRouter();
+    EndpointRouter.StartProbing();
+}
+
+int32 FTokebiAnalyticsTestAccess::GetQueuedEventCount()
+{
+    FScopeLock Lock(&EventQueueLock);
+    return EventQueue.Num() + ContextEventCount;
+}
+
+uint32 FTokebiAnalyticsTestAccess::GetBatchesCreated()
+{
+    return NextBatchId.load() - 1;
+}
+
+bool FTokebiAnalyticsTestAccess::IsEndpointHealthy(int32 Index)
+{
+    return EndpointRouter.IsHealthy(Index);
+}
+
+int32 FTokebiAnalyticsTestAccess::GetMaxBatchEvents()
+{
+    return MAX_BATCH_EVENTS;
+}
+
+int32 FTokebiAnalyticsTestAccess::GetMaxQueueSize()
+{
+    return MAX_QUEUE_SIZE;
+}
+
+FString FTokebiAnalyticsTestAccess::GetPreferredEndpoint()
+{
+    return EndpointRouter.GetBaseUrl(EndpointRouter.SelectEndpoint(TSet<int32>()));
+}
+
+int32 FTokebiAnalyticsTestAccess::GetStateCacheCount()
+{
+    FScopeLock Lock(&StateCacheLock);
+    return StateCaches.Num();
+}
+
+void FTokebiAnalyticsTestAccess::ReloadOfflineEvents()
+{
+    UTokebiAnalyticsFunctions::LoadEventsFromFile();
+}
+
+FString FTokebiAnalyticsTestAccess::GetOfflineEventsPath()
+{
+    return UTokebiAnalyticsFunctions::GetOfflineEventsPath();
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
\ No newline at end of file
@@ -5,6 +5,22 @@
 #include "Engine/World.h"
 #include "TokebiAnalyticsFunctions.generated.h"
 
+class APlayerController;
+
+// Handle to a per-player tracking context. Contexts let a dedicated server attribute
+// events to many players while sharing one batching and upload pipeline.
+USTRUCT(BlueprintType)
+struct TOKEBIANALYTICS_API FTokebiPlayerContext
+{
+    GENERATED_BODY()
+
+    // 0 means no context (the local player tracked by the plain Tokebi functions)
+    UPROPERTY(BlueprintReadOnly, Category = "Tokebi Analytics")
+    int32 ContextId = 0;
+
+    bool IsValid() const { return ContextId > 0; }
+};
+
 UCLASS()
 class TOKEBIANALYTICS_API UTokebiAnalyticsFunctions : public UBlueprintFunctionLibrary
 {
@@ -33,13 +49,51 @@ public:
     UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics")
     static void TokebiTrackPurchase(FString ItemId, FString Currency, int32 Cost);
     
+    // Sends only the fields that changed since the last snapshot of this state, plus periodic full keyframes
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics")
+    static void TokebiTrackState(FString StateName, const TMap<FString, FString>& StateData);
+    
     UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics")
     static void TokebiFlushEvents();
+    
+    // Player contexts (dedicated servers)
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static FTokebiPlayerContext TokebiCreatePlayerContext(APlayerController* PlayerController);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static FTokebiPlayerContext TokebiCreatePlayerContextWithID(FString PlayerId);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static void TokebiDestroyPlayerContext(FTokebiPlayerContext Context);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static void TokebiStartContextSession(FTokebiPlayerContext Context);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static void TokebiEndContextSession(FTokebiPlayerContext Context);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static void TokebiTrackForContext(FTokebiPlayerContext Context, FString EventName, const TMap<FString, FString>& EventData);
+    
+    UFUNCTION(BlueprintCallable, meta = (Keywords = "Tokebi analytics"), Category = "Tokebi Analytics|Player Context")
+    static void TokebiTrackStateForContext(FTokebiPlayerContext Context, FString StateName, const TMap<FString, FString>& StateData);
+    
+    // Called by the module on shutdown - removes the flush and endpoint probe tickers
+    static void ShutdownTokebiSystem();
 
 private:
+    // Reads the offline store path
+    friend class UTokebiOfflineEventsCommandlet;
+    friend struct FTokebiAnalyticsTestAccess;
+    
     // Core system
     static void InitializeTokebiSystem();
-    static void QueueEvent(const FString& EventType, const TMap<FString, FString>& EventData);
+    // Returns false if the event was dropped. EventFields are copied onto the event next to its payload.
+    // When the queue fills up it is flushed right away, unless OutFlushNeeded is given: then it is set
+    // instead, so a caller holding a lock of its own can flush once it has let go.
+    static bool QueueEvent(const FString& EventType, const TMap<FString, FString>& EventData, int32 ContextId = 0,
+                           bool bAllowCoalesce = true, const TSharedPtr<class FJsonObject>& EventFields = nullptr,
+                           bool* OutFlushNeeded = nullptr);
     static void FlushQueuedEvents();
     
     // 🔧 TICKER FUNCTIONS - ADDED
@@ -53,6 +107,10 @@ private:
     // HTTP handling
     static void SendHTTPRequest(const FString& Endpoint, const FString& JsonPayload, TFunction<void(bool, int32, FString)> Callback);
     
+    // Endpoint routing - sends a track batch to the best endpoint, failing over to the others
+    static void ConfigureEndpointRouter();
+    static void SendTrackRequest(uint32 BatchId, const FString& JsonPayload, TFunction<void(bool, int32, FString)> Callback, TSet<int32> TriedEndpoints = TSet<int32>());
+    
     // Offline persistence
     static void SaveEventsToFile(const TArray<TSharedPtr<class FJsonObject>>& Events);
     static void LoadEventsFromFile();
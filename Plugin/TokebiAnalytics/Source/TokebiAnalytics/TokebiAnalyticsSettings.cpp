@@ -6,5 +6,11 @@ UTokebiAnalyticsSettings::UTokebiAnalyticsSettings(const FObjectInitializer& Obj
     , TokebiGameId(TEXT(""))
     , TokebiEndpoint(TEXT("https://tokebi-api.vercel.app"))  // 🔧 REMOVED /track
     , TokebiEnvironment(TEXT("development"))
+    , EndpointProbeInterval(60.0f)
+    , bCoalesceDuplicateEvents(false)
+    , CoalesceWindowSeconds(30.0f)
+    , StateKeyframeInterval(10)
+    , StateKeyframeSeconds(300.0f)
+    , bCorrectClockSkew(true)
 {
 }
\ No newline at end of file
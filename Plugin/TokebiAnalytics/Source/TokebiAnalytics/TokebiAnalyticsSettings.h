@@ -23,4 +23,32 @@ public:
     
     UPROPERTY(Config, EditAnywhere, Category=General, meta=(DisplayName="Environment"))
     FString TokebiEnvironment;
+    
+    // Extra ingestion endpoints. Each batch goes to the fastest healthy one of these and the API Endpoint.
+    UPROPERTY(Config, EditAnywhere, Category=Routing, meta=(DisplayName="Additional Ingestion Endpoints"))
+    TArray<FString> TokebiIngestionEndpoints;
+    
+    // How often each endpoint is probed for health and round-trip time, in seconds
+    UPROPERTY(Config, EditAnywhere, Category=Routing, meta=(DisplayName="Endpoint Probe Interval", ClampMin="5.0"))
+    float EndpointProbeInterval;
+    
+    // Merge identical events (same event type and payload) tracked within the window into one event with a count
+    UPROPERTY(Config, EditAnywhere, Category=Batching, meta=(DisplayName="Coalesce Duplicate Events"))
+    bool bCoalesceDuplicateEvents;
+    
+    // Longest span between the first and last occurrence of a coalesced event, in seconds
+    UPROPERTY(Config, EditAnywhere, Category=Batching, meta=(DisplayName="Coalesce Window", ClampMin="0.0", EditCondition="bCoalesceDuplicateEvents"))
+    float CoalesceWindowSeconds;
+    
+    // TokebiTrackState sends a full keyframe after this many deltas (0 = never)
+    UPROPERTY(Config, EditAnywhere, Category=StateTracking, meta=(DisplayName="Deltas Between Keyframes", ClampMin="0"))
+    int32 StateKeyframeInterval;
+    
+    // ...or when this many seconds have passed since the last keyframe (0 = never)
+    UPROPERTY(Config, EditAnywhere, Category=StateTracking, meta=(DisplayName="Max Seconds Between Keyframes", ClampMin="0.0"))
+    float StateKeyframeSeconds;
+    
+    // Adjust batch timestamps by the offset between the device clock and the server's Date header
+    UPROPERTY(Config, EditAnywhere, Category=Timestamps, meta=(DisplayName="Correct Clock Skew"))
+    bool bCorrectClockSkew;
 };
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsSettings.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpPath.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/EngineVersionComparison.h"
+
+FTokebiMockIngestionServer::FTokebiMockIngestionServer(uint32 InPort)
+    : Port(InPort)
+{
+    Router = FHttpServerModule::Get().GetHttpRouter(Port);
+    if (!Router.IsValid())
+    {
+        return;
+    }
+
+    auto Handler = [this](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+    {
+        return HandleRequest(Request, OnComplete);
+    };
+
+#if UE_VERSION_NEWER_THAN(5, 3, 0)
+    RouteHandle = Router->BindRoute(FHttpPath(TEXT("/api/track")), EHttpServerRequestVerbs::VERB_POST | EHttpServerRequestVerbs::VERB_HEAD, FHttpRequestHandler::CreateLambda(Handler));
+#else
+    RouteHandle = Router->BindRoute(FHttpPath(TEXT("/api/track")), EHttpServerRequestVerbs::VERB_POST | EHttpServerRequestVerbs::VERB_HEAD, Handler);
+#endif
+
+    // Listeners stay up until the module shuts down; unbinding the route is enough to retire a mock
+    FHttpServerModule::Get().StartAllListeners();
+}
+
+FTokebiMockIngestionServer::~FTokebiMockIngestionServer()
+{
+    if (Router.IsValid() && RouteHandle.IsValid())
+    {
+        Router->UnbindRoute(RouteHandle);
+    }
+}
+
+FString FTokebiMockIngestionServer::GetBaseUrl() const
+{
+    return FString::Printf(TEXT("http://127.0.0.1:%u"), Port);
+}
+
+bool FTokebiMockIngestionServer::HandleRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+    const bool bProbe = Request.Verb == EHttpServerRequestVerbs::VERB_HEAD;
+    const bool bAccepted = ResponseCode >= 200 && ResponseCode < 300;
+
+    if (bProbe)
+    {
+        ProbeRequests++;
+    }
+    else
+    {
+        TrackRequests++;
+    }
+
+    if (!bProbe && bAccepted)
+    {
+        FUTF8ToTCHAR Converter((const ANSICHAR*)Request.Body.GetData(), Request.Body.Num());
+        const FString Body(Converter.Length(), Converter.Get());
+
+        TSharedPtr<FJsonObject> Batch;
+        if (FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Body), Batch) && Batch.IsValid())
+        {
+            const int32 EventsBefore = ReceivedEvents.Num();
+            const double SentAt = Batch->GetNumberField(TEXT("sentAt"));
+            const TArray<TSharedPtr<FJsonValue>>* Events = nullptr;
+            if (Batch->TryGetArrayField(TEXT("events"), Events))
+            {
+                for (const TSharedPtr<FJsonValue>& Event : *Events)
+                {
+                    Event->AsObject()->SetNumberField(TEXT("sentAt"), SentAt);
+                    ReceivedEvents.Add(Event->AsObject());
+                }
+            }
+
+            const TArray<TSharedPtr<FJsonValue>>* Contexts = nullptr;
+            if (Batch->TryGetArrayField(TEXT("contexts"), Contexts))
+            {
+                for (const TSharedPtr<FJsonValue>& ContextValue : *Contexts)
+                {
+                    const TSharedPtr<FJsonObject> Context = ContextValue->AsObject();
+                    const FString PlayerId = Context->GetStringField(TEXT("playerId"));
+                    for (const TSharedPtr<FJsonValue>& Event : Context->GetArrayField(TEXT("events")))
+                    {
+                        Event->AsObject()->SetStringField(TEXT("playerId"), PlayerId);
+                        Event->AsObject()->SetNumberField(TEXT("sentAt"), SentAt);
+                        ReceivedEvents.Add(Event->AsObject());
+                    }
+                }
+            }
+
+            LargestBatchEvents = FMath::Max(LargestBatchEvents, ReceivedEvents.Num() - EventsBefore);
+        }
+    }
+
+    const int32 Code = bProbe && ProbeResponseCode != 0 ? ProbeResponseCode : ResponseCode;
+    const int32 ClockOffset = ClockOffsetSeconds;
+    auto Respond = [OnComplete, Code, ClockOffset]()
+    {
+        TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(TEXT("{}"), TEXT("application/json"));
+        Response->Code = (EHttpServerResponseCodes)Code;
+        if (ClockOffset != 0)
+        {
+            Response->Headers.Add(TEXT("Date"), { (FDateTime::UtcNow() + FTimespan::FromSeconds(ClockOffset)).ToHttpDate() });
+        }
+        OnComplete(MoveTemp(Response));
+    };
+
+    if (DelaySeconds > 0.0f)
+    {
+        FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Respond](float DeltaTime) -> bool
+        {
+            Respond();
+            return false;
+        }), DelaySeconds);
+    }
+    else
+    {
+        Respond();
+    }
+    return true;
+}
+
+FTokebiTestEnvironment::FTokebiTestEnvironment()
+{
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    SavedApiKey = Settings->TokebiApiKey;
+    SavedGameId = Settings->TokebiGameId;
+    SavedEndpoint = Settings->TokebiEndpoint;
+    SavedIngestionEndpoints = Settings->TokebiIngestionEndpoints;
+    SavedProbeInterval = Settings->EndpointProbeInterval;
+    bSavedCoalesce = Settings->bCoalesceDuplicateEvents;
+    SavedCoalesceWindow = Settings->CoalesceWindowSeconds;
+    bSavedCorrectClockSkew = Settings->bCorrectClockSkew;
+    SavedKeyframeInterval = Settings->StateKeyframeInterval;
+    SavedKeyframeSeconds = Settings->StateKeyframeSeconds;
+
+    Settings->TokebiApiKey = TEXT("test_api_key");
+    Settings->TokebiGameId = TEXT("test_game");
+    Settings->bCoalesceDuplicateEvents = false;
+    Settings->bCorrectClockSkew = false;
+
+    // Keep the project's unsent events out of the way of the test
+    const FString OfflinePath = FTokebiAnalyticsTestAccess::GetOfflineEventsPath();
+    bHadOfflineEvents = IFileManager::Get().FileExists(*OfflinePath);
+    if (bHadOfflineEvents)
+    {
+        IFileManager::Get().Move(*(OfflinePath + TEXT(".testbackup")), *OfflinePath);
+    }
+
+    FTokebiAnalyticsTestAccess::ResetPipeline();
+}
+
+FTokebiTestEnvironment::~FTokebiTestEnvironment()
+{
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    Settings->TokebiApiKey = SavedApiKey;
+    Settings->TokebiGameId = SavedGameId;
+    Settings->TokebiEndpoint = SavedEndpoint;
+    Settings->TokebiIngestionEndpoints = SavedIngestionEndpoints;
+    Settings->EndpointProbeInterval = SavedProbeInterval;
+    Settings->bCoalesceDuplicateEvents = bSavedCoalesce;
+    Settings->CoalesceWindowSeconds = SavedCoalesceWindow;
+    Settings->bCorrectClockSkew = bSavedCorrectClockSkew;
+    Settings->StateKeyframeInterval = SavedKeyframeInterval;
+    Settings->StateKeyframeSeconds = SavedKeyframeSeconds;
+
+    const FString OfflinePath = FTokebiAnalyticsTestAccess::GetOfflineEventsPath();
+    IFileManager::Get().Delete(*OfflinePath);
+    if (bHadOfflineEvents)
+    {
+        IFileManager::Get().Move(*OfflinePath, *(OfflinePath + TEXT(".testbackup")));
+    }
+
+    FTokebiAnalyticsTestAccess::ResetPipeline();
+}
+
+void FTokebiTestEnvironment::SetEndpoints(const FString& Primary, const TArray<FString>& Additional, float ProbeInterval)
+{
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    Settings->TokebiEndpoint = Primary;
+    Settings->TokebiIngestionEndpoints = Additional;
+    Settings->EndpointProbeInterval = ProbeInterval;
+
+    FTokebiAnalyticsTestAccess::ResetPipeline();
+}
+
+void TokebiAddWaitUntil(FAutomationTestBase* Test, const FString& Description, TFunction<bool()> Done, double TimeoutSeconds)
+{
+    TSharedRef<double> StartTime = MakeShared<double>(0.0);
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Test, Description, Done, TimeoutSeconds, StartTime]() -> bool
+    {
+        if (*StartTime == 0.0)
+        {
+            *StartTime = FPlatformTime::Seconds();
+        }
+
+        if (Done())
+        {
+            return true;
+        }
+
+        if (FPlatformTime::Seconds() - *StartTime > TimeoutSeconds)
+        {
+            Test->AddError(FString::Printf(TEXT("Timed out after %.0f s waiting for: %s"), TimeoutSeconds, *Description));
+            return true;
+        }
+        return false;
+    }));
+}
+
+void TokebiAddStep(TFunction<void()> Step)
+{
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Step]() -> bool
+    {
+        Step();
+        return true;
+    }));
+}
+
+void TokebiAddDelay(float Seconds)
+{
+    TSharedRef<double> StartTime = MakeShared<double>(0.0);
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Seconds, StartTime]() -> bool
+    {
+        if (*StartTime == 0.0)
+        {
+            *StartTime = FPlatformTime::Seconds();
+        }
+        return FPlatformTime::Seconds() - *StartTime >= Seconds;
+    }));
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
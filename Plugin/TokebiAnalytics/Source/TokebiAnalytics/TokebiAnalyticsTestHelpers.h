@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Misc/AutomationTest.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+class FJsonObject;
+
+/**
+ * Shared fixtures for the plugin's automation tests (Session Frontend → Automation → TokebiAnalytics).
+ * Tests run the real pipeline against local mock servers, so they need a game thread that keeps
+ * ticking; each test queues latent steps rather than blocking.
+ */
+
+// Reaches into the plugin's file-level state. Defined in TokebiAnalyticsFunctions.cpp.
+struct FTokebiAnalyticsTestAccess
+{
+    // Drops queued events, player contexts, state caches and stats, forgets the clock skew, and
+    // restarts endpoint routing from the current settings with no health or RTT history
+    static void ResetPipeline();
+
+    // Queues the offline events file the way startup does
+    static void ReloadOfflineEvents();
+
+    static int32 GetQueuedEventCount();
+    static uint32 GetBatchesCreated();
+    static int32 GetMaxBatchEvents();
+    static int32 GetMaxQueueSize();
+    static bool IsEndpointHealthy(int32 Index);
+    static FString GetPreferredEndpoint();
+    static int32 GetStateCacheCount();
+    static FString GetOfflineEventsPath();
+};
+
+// Local stand-in for an ingestion endpoint. Answers POST and HEAD /api/track with ResponseCode
+// (HEAD with ProbeResponseCode if set) after DelaySeconds, and records the events of every batch it accepts. With ClockOffsetSeconds
+// set, responses carry a Date header that far from the local clock.
+class FTokebiMockIngestionServer
+{
+public:
+    explicit FTokebiMockIngestionServer(uint32 InPort);
+    ~FTokebiMockIngestionServer();
+
+    FString GetBaseUrl() const;
+
+    // Behaviour, can be changed mid-test
+    int32 ResponseCode = 200;
+    int32 ProbeResponseCode = 0;
+    float DelaySeconds = 0.0f;
+    int32 ClockOffsetSeconds = 0;
+
+    // What it has seen. Context events are flattened in batch order with their playerId set, and
+    // every event gets its batch's sentAt so its time is sentAt + timeOffsetMs.
+    int32 TrackRequests = 0;
+    int32 ProbeRequests = 0;
+    int32 LargestBatchEvents = 0;
+    TArray<TSharedPtr<FJsonObject>> ReceivedEvents;
+
+private:
+    bool HandleRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+    uint32 Port;
+    TSharedPtr<IHttpRouter> Router;
+    FHttpRouteHandle RouteHandle;
+};
+
+// Points the plugin at test settings for the lifetime of the object, then restores the project's
+// settings and offline events file. Keep it alive until the last latent step has run.
+class FTokebiTestEnvironment
+{
+public:
+    FTokebiTestEnvironment();
+    ~FTokebiTestEnvironment();
+
+    void SetEndpoints(const FString& Primary, const TArray<FString>& Additional, float ProbeInterval = 60.0f);
+
+private:
+    FString SavedApiKey;
+    FString SavedGameId;
+    FString SavedEndpoint;
+    TArray<FString> SavedIngestionEndpoints;
+    float SavedProbeInterval = 0.0f;
+    bool bSavedCoalesce = false;
+    float SavedCoalesceWindow = 0.0f;
+    bool bSavedCorrectClockSkew = false;
+    int32 SavedKeyframeInterval = 0;
+    float SavedKeyframeSeconds = 0.0f;
+    bool bHadOfflineEvents = false;
+};
+
+// Queues a latent step that waits until Done returns true, failing the test after TimeoutSeconds
+void TokebiAddWaitUntil(FAutomationTestBase* Test, const FString& Description, TFunction<bool()> Done, double TimeoutSeconds = 10.0);
+
+// Queues a latent step that runs Step once
+void TokebiAddStep(TFunction<void()> Step);
+
+// Queues a latent step that lets the engine tick for Seconds
+void TokebiAddDelay(float Seconds);
+
+#endif // WITH_DEV_AUTOMATION_TESTS
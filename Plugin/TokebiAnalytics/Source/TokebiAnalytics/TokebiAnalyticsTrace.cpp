@@ -0,0 +1,91 @@
+#include "TokebiAnalyticsTrace.h"
+
+#if UE_TRACE_ENABLED
+
+#include "HAL/PlatformTime.h"
+
+UE_TRACE_CHANNEL_DEFINE(TokebiChannel)
+
+UE_TRACE_EVENT_BEGIN(TokebiAnalytics, BatchCreated)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, BatchId)
+    UE_TRACE_EVENT_FIELD(uint32, EventCount)
+    UE_TRACE_EVENT_FIELD(uint32, ContextCount)
+    UE_TRACE_EVENT_FIELD(uint32, Bytes)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TokebiAnalytics, BatchSent)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, BatchId)
+    UE_TRACE_EVENT_FIELD(uint32, Attempt)
+    UE_TRACE_EVENT_FIELD(uint32, Bytes)
+    UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Endpoint)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TokebiAnalytics, BatchAcked)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, BatchId)
+    UE_TRACE_EVENT_FIELD(int32, ResponseCode)
+    UE_TRACE_EVENT_FIELD(double, LatencyMs)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TokebiAnalytics, BatchRetried)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, BatchId)
+    UE_TRACE_EVENT_FIELD(uint32, Attempt)
+    UE_TRACE_EVENT_FIELD(int32, ResponseCode)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TokebiAnalytics, EventsSpilled)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, EventCount)
+    UE_TRACE_EVENT_FIELD(uint32, Bytes)
+UE_TRACE_EVENT_END()
+
+void FTokebiAnalyticsTrace::OutputBatchCreated(uint32 BatchId, uint32 EventCount, uint32 ContextCount, uint32 Bytes)
+{
+    UE_TRACE_LOG(TokebiAnalytics, BatchCreated, TokebiChannel)
+        << BatchCreated.Cycle(FPlatformTime::Cycles64())
+        << BatchCreated.BatchId(BatchId)
+        << BatchCreated.EventCount(EventCount)
+        << BatchCreated.ContextCount(ContextCount)
+        << BatchCreated.Bytes(Bytes);
+}
+
+void FTokebiAnalyticsTrace::OutputBatchSent(uint32 BatchId, uint32 Attempt, uint32 Bytes, const FString& Endpoint)
+{
+    UE_TRACE_LOG(TokebiAnalytics, BatchSent, TokebiChannel)
+        << BatchSent.Cycle(FPlatformTime::Cycles64())
+        << BatchSent.BatchId(BatchId)
+        << BatchSent.Attempt(Attempt)
+        << BatchSent.Bytes(Bytes)
+        << BatchSent.Endpoint(*Endpoint, Endpoint.Len());
+}
+
+void FTokebiAnalyticsTrace::OutputBatchAcked(uint32 BatchId, int32 ResponseCode, double LatencyMs)
+{
+    UE_TRACE_LOG(TokebiAnalytics, BatchAcked, TokebiChannel)
+        << BatchAcked.Cycle(FPlatformTime::Cycles64())
+        << BatchAcked.BatchId(BatchId)
+        << BatchAcked.ResponseCode(ResponseCode)
+        << BatchAcked.LatencyMs(LatencyMs);
+}
+
+void FTokebiAnalyticsTrace::OutputBatchRetried(uint32 BatchId, uint32 Attempt, int32 ResponseCode)
+{
+    UE_TRACE_LOG(TokebiAnalytics, BatchRetried, TokebiChannel)
+        << BatchRetried.Cycle(FPlatformTime::Cycles64())
+        << BatchRetried.BatchId(BatchId)
+        << BatchRetried.Attempt(Attempt)
+        << BatchRetried.ResponseCode(ResponseCode);
+}
+
+void FTokebiAnalyticsTrace::OutputEventsSpilled(uint32 EventCount, uint32 Bytes)
+{
+    UE_TRACE_LOG(TokebiAnalytics, EventsSpilled, TokebiChannel)
+        << EventsSpilled.Cycle(FPlatformTime::Cycles64())
+        << EventsSpilled.EventCount(EventCount)
+        << EventsSpilled.Bytes(Bytes);
+}
+
+#endif // UE_TRACE_ENABLED
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+ * Unreal Insights support. Enable with -trace=cpu,tokebi to see every pipeline stage as a
+ * CPU timer and batch lifecycle events (created, sent, acked, retried, spilled) on the timeline.
+ */
+#if UE_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(TokebiChannel)
+
+struct FTokebiAnalyticsTrace
+{
+    static void OutputBatchCreated(uint32 BatchId, uint32 EventCount, uint32 ContextCount, uint32 Bytes);
+    static void OutputBatchSent(uint32 BatchId, uint32 Attempt, uint32 Bytes, const FString& Endpoint);
+    static void OutputBatchAcked(uint32 BatchId, int32 ResponseCode, double LatencyMs);
+    static void OutputBatchRetried(uint32 BatchId, uint32 Attempt, int32 ResponseCode);
+    static void OutputEventsSpilled(uint32 EventCount, uint32 Bytes);
+};
+
+#define TOKEBI_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, TokebiChannel)
+#define TOKEBI_TRACE_BATCH_CREATED(BatchId, EventCount, ContextCount, Bytes) FTokebiAnalyticsTrace::OutputBatchCreated(BatchId, EventCount, ContextCount, Bytes)
+#define TOKEBI_TRACE_BATCH_SENT(BatchId, Attempt, Bytes, Endpoint) FTokebiAnalyticsTrace::OutputBatchSent(BatchId, Attempt, Bytes, Endpoint)
+#define TOKEBI_TRACE_BATCH_ACKED(BatchId, ResponseCode, LatencyMs) FTokebiAnalyticsTrace::OutputBatchAcked(BatchId, ResponseCode, LatencyMs)
+#define TOKEBI_TRACE_BATCH_RETRIED(BatchId, Attempt, ResponseCode) FTokebiAnalyticsTrace::OutputBatchRetried(BatchId, Attempt, ResponseCode)
+#define TOKEBI_TRACE_EVENTS_SPILLED(EventCount, Bytes) FTokebiAnalyticsTrace::OutputEventsSpilled(EventCount, Bytes)
+
+#else
+
+#define TOKEBI_TRACE_SCOPE(Name)
+#define TOKEBI_TRACE_BATCH_CREATED(BatchId, EventCount, ContextCount, Bytes)
+#define TOKEBI_TRACE_BATCH_SENT(BatchId, Attempt, Bytes, Endpoint)
+#define TOKEBI_TRACE_BATCH_ACKED(BatchId, ResponseCode, LatencyMs)
+#define TOKEBI_TRACE_BATCH_RETRIED(BatchId, Attempt, ResponseCode)
+#define TOKEBI_TRACE_EVENTS_SPILLED(EventCount, Bytes)
+
+#endif
@@ -0,0 +1,72 @@
+#include "TokebiCoalescingTable.h"
+
+// Power of two so the probe can mask instead of divide
+static const int32 INITIAL_SLOTS = 256;
+
+int32* FTokebiCoalescingTable::Find(uint64 Hash, int32 ContextId, TFunctionRef<bool(int32 EventIndex)> IsMatch)
+{
+    if (NumEntries == 0)
+    {
+        return nullptr;
+    }
+
+    const int32 Mask = Slots.Num() - 1;
+    for (int32 SlotIndex = (int32)(Hash & Mask); ; SlotIndex = (SlotIndex + 1) & Mask)
+    {
+        FSlot& Slot = Slots[SlotIndex];
+        if (Slot.EventIndex == INDEX_NONE)
+        {
+            return nullptr;
+        }
+
+        if (Slot.Hash == Hash && Slot.ContextId == ContextId && IsMatch(Slot.EventIndex))
+        {
+            return &Slot.EventIndex;
+        }
+    }
+}
+
+void FTokebiCoalescingTable::Add(uint64 Hash, int32 ContextId, int32 EventIndex)
+{
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    if ((NumEntries + 1) * 2 > Slots.Num())
+    {
+        Grow();
+    }
+
+    const int32 Mask = Slots.Num() - 1;
+    int32 SlotIndex = (int32)(Hash & Mask);
+    while (Slots[SlotIndex].EventIndex != INDEX_NONE)
+    {
+        SlotIndex = (SlotIndex + 1) & Mask;
+    }
+
+    Slots[SlotIndex] = { Hash, ContextId, EventIndex };
+    NumEntries++;
+}
+
+void FTokebiCoalescingTable::Reset()
+{
+    if (NumEntries > 0)
+    {
+        FMemory::Memset(Slots.GetData(), 0xFF, Slots.Num() * sizeof(FSlot));
+        NumEntries = 0;
+    }
+}
+
+void FTokebiCoalescingTable::Grow()
+{
+    TArray<FSlot> OldSlots = MoveTemp(Slots);
+
+    Slots.SetNumUninitialized(FMath::Max(OldSlots.Num() * 2, INITIAL_SLOTS));
+    FMemory::Memset(Slots.GetData(), 0xFF, Slots.Num() * sizeof(FSlot));
+    NumEntries = 0;
+
+    for (const FSlot& Slot : OldSlots)
+    {
+        if (Slot.EventIndex != INDEX_NONE)
+        {
+            Add(Slot.Hash, Slot.ContextId, Slot.EventIndex);
+        }
+    }
+}
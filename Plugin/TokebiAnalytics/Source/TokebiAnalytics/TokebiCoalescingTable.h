@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact open-addressing (linear probing) table used to find a queued event that an
+ * identical new event can be merged into. Keys are a hash of (context, eventType, payload);
+ * values are the event's index in its context's queue. Hash collisions are resolved by the
+ * caller's match function, so only genuinely identical events are merged.
+ *
+ * Reset() keeps the allocation, so after warm-up clearing it every flush costs one memset.
+ * Not thread-safe; guarded by the event queue lock.
+ */
+class FTokebiCoalescingTable
+{
+public:
+    // Returns the stored event index for a matching entry, or null. The index can be overwritten.
+    int32* Find(uint64 Hash, int32 ContextId, TFunctionRef<bool(int32 EventIndex)> IsMatch);
+
+    void Add(uint64 Hash, int32 ContextId, int32 EventIndex);
+
+    void Reset();
+
+private:
+    struct FSlot
+    {
+        uint64 Hash;
+        int32 ContextId;
+        int32 EventIndex; // INDEX_NONE marks an empty slot
+    };
+
+    void Grow();
+
+    TArray<FSlot> Slots;
+    int32 NumEntries = 0;
+};
@@ -0,0 +1,244 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsFunctions.h"
+#include "TokebiAnalyticsSettings.h"
+#include "Dom/JsonObject.h"
+
+// Each test gets its own mock, on COALESCING_MOCK_PORT and up
+static const uint32 COALESCING_MOCK_PORT = 18750;
+
+// Sandbox with coalescing switched on and a mock to flush to
+struct FTokebiCoalescingFixture
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedPtr<FTokebiMockIngestionServer> Server;
+
+    TArray<TSharedPtr<FJsonObject>> GetEvents(const FString& EventType) const
+    {
+        return Server->ReceivedEvents.FilterByPredicate([&EventType](const TSharedPtr<FJsonObject>& Event)
+        {
+            return Event->GetStringField(TEXT("eventType")) == EventType;
+        });
+    }
+};
+
+static TSharedRef<FTokebiCoalescingFixture> StartCoalescingFixture(uint32 PortOffset, float WindowSeconds = 30.0f)
+{
+    TSharedRef<FTokebiCoalescingFixture> Fixture = MakeShared<FTokebiCoalescingFixture>();
+    Fixture->Server = MakeShared<FTokebiMockIngestionServer>(COALESCING_MOCK_PORT + PortOffset);
+    Fixture->Environment->SetEndpoints(Fixture->Server->GetBaseUrl(), TArray<FString>());
+
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    Settings->bCoalesceDuplicateEvents = true;
+    Settings->CoalesceWindowSeconds = WindowSeconds;
+
+    return Fixture;
+}
+
+static TMap<FString, FString> MakePickup(const FString& Item)
+{
+    TMap<FString, FString> EventData;
+    EventData.Add(TEXT("item"), Item);
+    return EventData;
+}
+
+static int32 GetCount(const TSharedPtr<FJsonObject>& Event)
+{
+    int32 Count = 1;
+    Event->TryGetNumberField(TEXT("count"), Count);
+    return Count;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiCoalescingMergeTest, "TokebiAnalytics.Coalescing.MergesDuplicates",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiCoalescingMergeTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiCoalescingFixture> Fixture = StartCoalescingFixture(0);
+
+    for (int32 Index = 0; Index < 3; Index++)
+    {
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+    }
+
+    // The last occurrence is reported separately from the first
+    TokebiAddDelay(0.3f);
+
+    TokebiAddStep([]()
+    {
+        for (int32 Index = 0; Index < 2; Index++)
+        {
+            UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+        }
+        UTokebiAnalyticsFunctions::TokebiFlushEvents();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("pickup received"), [Fixture]() { return Fixture->GetEvents(TEXT("item_pickup")).Num() > 0; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = Fixture->GetEvents(TEXT("item_pickup"));
+        if (TestEqual(TEXT("Events received"), Events.Num(), 1))
+        {
+            TestEqual(TEXT("Count"), GetCount(Events[0]), 5);
+
+            double FirstMs = 0.0;
+            double LastMs = 0.0;
+            TestTrue(TEXT("Has timeOffsetMs"), Events[0]->TryGetNumberField(TEXT("timeOffsetMs"), FirstMs));
+            TestTrue(TEXT("Has lastTimeOffsetMs"), Events[0]->TryGetNumberField(TEXT("lastTimeOffsetMs"), LastMs));
+            TestTrue(FString::Printf(TEXT("Last occurrence %.0f ms after the first"), LastMs - FirstMs), LastMs - FirstMs >= 250.0);
+        }
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiCoalescingWindowTest, "TokebiAnalytics.Coalescing.WindowStartsNewEvent",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiCoalescingWindowTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiCoalescingFixture> Fixture = StartCoalescingFixture(1, 0.2f);
+
+    UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+
+    TokebiAddDelay(0.5f);
+
+    // Past the window: a new event, which the duplicates after it merge into
+    TokebiAddStep([]()
+    {
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+        UTokebiAnalyticsFunctions::TokebiFlushEvents();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("pickups received"), [Fixture]() { return Fixture->GetEvents(TEXT("item_pickup")).Num() >= 2; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = Fixture->GetEvents(TEXT("item_pickup"));
+        if (TestEqual(TEXT("Events received"), Events.Num(), 2))
+        {
+            TestFalse(TEXT("First event has no count"), Events[0]->HasField(TEXT("count")));
+            TestEqual(TEXT("Second event count"), GetCount(Events[1]), 2);
+        }
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiCoalescingContextsTest, "TokebiAnalytics.Coalescing.ContextsStaySeparate",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiCoalescingContextsTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiCoalescingFixture> Fixture = StartCoalescingFixture(2);
+
+    const FTokebiPlayerContext First = UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(TEXT("coalescing_player_1"));
+    const FTokebiPlayerContext Second = UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(TEXT("coalescing_player_2"));
+
+    // The same event from the local player and two others is three players' events
+    for (int32 Index = 0; Index < 2; Index++)
+    {
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+        UTokebiAnalyticsFunctions::TokebiTrackForContext(First, TEXT("item_pickup"), MakePickup(TEXT("potion")));
+        UTokebiAnalyticsFunctions::TokebiTrackForContext(Second, TEXT("item_pickup"), MakePickup(TEXT("potion")));
+    }
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("pickups received"), [Fixture]() { return Fixture->GetEvents(TEXT("item_pickup")).Num() >= 3; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = Fixture->GetEvents(TEXT("item_pickup"));
+        TestEqual(TEXT("Events received"), Events.Num(), 3);
+
+        TSet<FString> PlayerIds;
+        for (const TSharedPtr<FJsonObject>& Event : Events)
+        {
+            TestEqual(TEXT("Count"), GetCount(Event), 2);
+            PlayerIds.Add(Event->GetStringField(TEXT("playerId")));
+        }
+        TestEqual(TEXT("Distinct players"), PlayerIds.Num(), 3);
+        TestTrue(TEXT("First context"), PlayerIds.Contains(TEXT("coalescing_player_1")));
+        TestTrue(TEXT("Second context"), PlayerIds.Contains(TEXT("coalescing_player_2")));
+    });
+
+    return true;
+}
+
+// More distinct events than the table starts with, so it has to grow while holding live entries
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiCoalescingGrowthTest, "TokebiAnalytics.Coalescing.TableGrowth",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiCoalescingGrowthTest::RunTest(const FString& Parameters)
+{
+    static const int32 DISTINCT_EVENTS = 200;
+    static const int32 ROUNDS = 3;
+
+    TSharedRef<FTokebiCoalescingFixture> Fixture = StartCoalescingFixture(3);
+
+    // A player context, whose queues only force a flush at a full batch, so every round lands in the same table
+    const FTokebiPlayerContext Context = UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(TEXT("coalescing_growth_player"));
+    for (int32 Round = 0; Round < ROUNDS; Round++)
+    {
+        for (int32 Index = 0; Index < DISTINCT_EVENTS; Index++)
+        {
+            UTokebiAnalyticsFunctions::TokebiTrackForContext(Context, TEXT("item_pickup"), MakePickup(FString::Printf(TEXT("item_%03d"), Index)));
+        }
+    }
+    TestEqual(TEXT("Queued events"), FTokebiAnalyticsTestAccess::GetQueuedEventCount(), DISTINCT_EVENTS);
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("pickups received"), [Fixture]() { return Fixture->GetEvents(TEXT("item_pickup")).Num() >= DISTINCT_EVENTS; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = Fixture->GetEvents(TEXT("item_pickup"));
+        TestEqual(TEXT("Events received"), Events.Num(), DISTINCT_EVENTS);
+
+        TSet<FString> Items;
+        int32 WrongCounts = 0;
+        for (const TSharedPtr<FJsonObject>& Event : Events)
+        {
+            Items.Add(Event->GetObjectField(TEXT("payload"))->GetStringField(TEXT("item")));
+            WrongCounts += GetCount(Event) != ROUNDS ? 1 : 0;
+        }
+        TestEqual(TEXT("Distinct items"), Items.Num(), DISTINCT_EVENTS);
+        TestEqual(TEXT("Events with the wrong count"), WrongCounts, 0);
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiCoalescingFlushTest, "TokebiAnalytics.Coalescing.FlushResetsTable",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiCoalescingFlushTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiCoalescingFixture> Fixture = StartCoalescingFixture(4);
+
+    // The first event has left the queue, so the second can't merge into it
+    UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+    UTokebiAnalyticsFunctions::TokebiTrack(TEXT("item_pickup"), MakePickup(TEXT("potion")));
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("pickups received"), [Fixture]() { return Fixture->GetEvents(TEXT("item_pickup")).Num() >= 2; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = Fixture->GetEvents(TEXT("item_pickup"));
+        TestEqual(TEXT("Events received"), Events.Num(), 2);
+        for (const TSharedPtr<FJsonObject>& Event : Events)
+        {
+            TestFalse(TEXT("Event has no count"), Event->HasField(TEXT("count")));
+        }
+    });
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,255 @@
+#include "TokebiEndpointRouter.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/PlatformTime.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTokebiAnalytics, Log, All);
+
+// Weight of a new RTT sample in the moving average
+static const double RTT_SMOOTHING = 0.2;
+
+static double SmoothRtt(double SmoothedRttMs, double RttMs)
+{
+    return SmoothedRttMs > 0.0 ? FMath::Lerp(SmoothedRttMs, RttMs, RTT_SMOOTHING) : RttMs;
+}
+
+void FTokebiEndpointRouter::Configure(const TArray<FString>& BaseUrls, float InProbeInterval, const FString& InApiKey)
+{
+    FScopeLock ScopeLock(&Lock);
+
+    TArray<FEndpointState> NewEndpoints;
+    for (const FString& BaseUrl : BaseUrls)
+    {
+        if (BaseUrl.IsEmpty() || NewEndpoints.ContainsByPredicate([&BaseUrl](const FEndpointState& State) { return State.BaseUrl == BaseUrl; }))
+        {
+            continue;
+        }
+
+        const FEndpointState* Existing = Endpoints.FindByPredicate([&BaseUrl](const FEndpointState& State) { return State.BaseUrl == BaseUrl; });
+        if (Existing)
+        {
+            NewEndpoints.Add(*Existing);
+        }
+        else
+        {
+            FEndpointState& State = NewEndpoints.AddDefaulted_GetRef();
+            State.BaseUrl = BaseUrl;
+        }
+    }
+
+    Endpoints = MoveTemp(NewEndpoints);
+    ProbeInterval = FMath::Max(InProbeInterval, 1.0f);
+    ApiKey = InApiKey;
+
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("Routing events across %d endpoint(s)"), Endpoints.Num());
+}
+
+int32 FTokebiEndpointRouter::SelectEndpoint(const TSet<int32>& Exclude) const
+{
+    FScopeLock ScopeLock(&Lock);
+
+    int32 Best = INDEX_NONE;
+    for (int32 Index = 0; Index < Endpoints.Num(); Index++)
+    {
+        if (Exclude.Contains(Index))
+        {
+            continue;
+        }
+
+        if (Best == INDEX_NONE)
+        {
+            Best = Index;
+            continue;
+        }
+
+        const FEndpointState& Candidate = Endpoints[Index];
+        const FEndpointState& Current = Endpoints[Best];
+        if (Candidate.bHealthy != Current.bHealthy)
+        {
+            if (Candidate.bHealthy)
+            {
+                Best = Index;
+            }
+        }
+        else if (!Candidate.bHealthy)
+        {
+            if (Candidate.ConsecutiveFailures < Current.ConsecutiveFailures)
+            {
+                Best = Index;
+            }
+        }
+        else if (Candidate.SmoothedBatchRttMs > 0.0 && Current.SmoothedBatchRttMs > 0.0)
+        {
+            if (Candidate.SmoothedBatchRttMs < Current.SmoothedBatchRttMs)
+            {
+                Best = Index;
+            }
+        }
+        else if (Candidate.SmoothedProbeRttMs < Current.SmoothedProbeRttMs)
+        {
+            Best = Index;
+        }
+    }
+    return Best;
+}
+
+FString FTokebiEndpointRouter::GetBaseUrl(int32 Index) const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Endpoints.IsValidIndex(Index) ? Endpoints[Index].BaseUrl : FString();
+}
+
+int32 FTokebiEndpointRouter::Num() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Endpoints.Num();
+}
+
+bool FTokebiEndpointRouter::IsHealthy(int32 Index) const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Endpoints.IsValidIndex(Index) && Endpoints[Index].bHealthy;
+}
+
+void FTokebiEndpointRouter::ReportSuccess(int32 Index, double RttMs)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (!Endpoints.IsValidIndex(Index))
+    {
+        return;
+    }
+
+    FEndpointState& State = Endpoints[Index];
+    MarkHealthy(State);
+    State.SmoothedBatchRttMs = SmoothRtt(State.SmoothedBatchRttMs, RttMs);
+}
+
+void FTokebiEndpointRouter::ReportFailure(int32 Index)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (!Endpoints.IsValidIndex(Index))
+    {
+        return;
+    }
+
+    FEndpointState& State = Endpoints[Index];
+    State.bHealthy = false;
+    State.ConsecutiveFailures++;
+    State.NextProbeTime = FPlatformTime::Seconds() + ProbeInterval;
+
+    UE_LOG(LogTokebiAnalytics, Warning, TEXT("Endpoint marked unhealthy (%d consecutive failures): %s"), State.ConsecutiveFailures, *State.BaseUrl);
+}
+
+void FTokebiEndpointRouter::StartProbing()
+{
+    StopProbing();
+
+    // Check often, each endpoint's NextProbeTime decides whether it is actually probed
+    ProbeTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateLambda([this](float DeltaTime) -> bool {
+            ProbeDueEndpoints();
+            return true; // Keep ticking
+        }),
+        1.0f
+    );
+}
+
+void FTokebiEndpointRouter::StopProbing()
+{
+    if (ProbeTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(ProbeTickerHandle);
+        ProbeTickerHandle.Reset();
+    }
+}
+
+void FTokebiEndpointRouter::ProbeDueEndpoints()
+{
+    TArray<FString> DueUrls;
+    FString ProbeApiKey;
+    {
+        FScopeLock ScopeLock(&Lock);
+
+        // With a single endpoint there's nothing to choose between
+        if (Endpoints.Num() < 2)
+        {
+            return;
+        }
+
+        ProbeApiKey = ApiKey;
+        const double Now = FPlatformTime::Seconds();
+        for (FEndpointState& State : Endpoints)
+        {
+            if (!State.bProbeInFlight && Now >= State.NextProbeTime)
+            {
+                State.bProbeInFlight = true;
+                State.NextProbeTime = Now + ProbeInterval;
+                DueUrls.Add(State.BaseUrl);
+            }
+        }
+    }
+
+    for (const FString& BaseUrl : DueUrls)
+    {
+        // HEAD keeps it cheap and has no side effects. The track route only has to accept POST, so
+        // any answer below 500 (405, 401, 404...) means the endpoint is up; only 5xx and network
+        // errors count against it. A batch that fails still marks the endpoint unhealthy.
+        TSharedRef<IHttpRequest> HttpRequest = FHttpModule::Get().CreateRequest();
+        HttpRequest->SetVerb(TEXT("HEAD"));
+        HttpRequest->SetURL(BaseUrl + TEXT("/api/track"));
+        HttpRequest->SetHeader(TEXT("Authorization"), ProbeApiKey);
+
+        const double StartTime = FPlatformTime::Seconds();
+        HttpRequest->OnProcessRequestComplete().BindLambda([this, BaseUrl, StartTime](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            const bool bReachable = bWasSuccessful && Response.IsValid() && Response->GetResponseCode() > 0 &&
+                                    Response->GetResponseCode() < EHttpResponseCodes::ServerError;
+            OnProbeComplete(BaseUrl, bReachable, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+        });
+
+        if (!HttpRequest->ProcessRequest())
+        {
+            OnProbeComplete(BaseUrl, false, 0.0);
+        }
+    }
+}
+
+void FTokebiEndpointRouter::OnProbeComplete(const FString& BaseUrl, bool bReachable, double RttMs)
+{
+    int32 Index = INDEX_NONE;
+    {
+        FScopeLock ScopeLock(&Lock);
+        Index = Endpoints.IndexOfByPredicate([&BaseUrl](const FEndpointState& State) { return State.BaseUrl == BaseUrl; });
+        if (Index == INDEX_NONE)
+        {
+            return; // Removed by Configure while the probe was running
+        }
+
+        FEndpointState& State = Endpoints[Index];
+        State.bProbeInFlight = false;
+        if (bReachable)
+        {
+            MarkHealthy(State);
+            State.SmoothedProbeRttMs = SmoothRtt(State.SmoothedProbeRttMs, RttMs);
+        }
+    }
+
+    UE_LOG(LogTokebiAnalytics, Verbose, TEXT("Probe %s: %s (%.0f ms)"), *BaseUrl, bReachable ? TEXT("reachable") : TEXT("unreachable"), RttMs);
+
+    if (!bReachable)
+    {
+        ReportFailure(Index);
+    }
+}
+
+void FTokebiEndpointRouter::MarkHealthy(FEndpointState& State)
+{
+    if (!State.bHealthy)
+    {
+        UE_LOG(LogTokebiAnalytics, Log, TEXT("✅ Endpoint healthy again: %s"), *State.BaseUrl);
+    }
+
+    State.bHealthy = true;
+    State.ConsecutiveFailures = 0;
+}
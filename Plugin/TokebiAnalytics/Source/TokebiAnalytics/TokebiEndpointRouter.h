@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+/**
+ * Tracks health and round-trip time of the configured ingestion endpoints and picks
+ * where each batch goes. Endpoints that fail are marked unhealthy. Every endpoint is
+ * probed each interval, which brings failed ones back and keeps the RTT of all of them
+ * comparable. Thread-safe.
+ */
+class FTokebiEndpointRouter
+{
+public:
+    // Replaces the endpoint list. Existing stats are kept for URLs that are still present.
+    // Probes send ApiKey like batches do, so gateways in front of the endpoint treat them the same.
+    void Configure(const TArray<FString>& BaseUrls, float InProbeInterval, const FString& InApiKey);
+
+    // Picks the fastest healthy endpoint not in Exclude, falling back to unhealthy ones
+    // with the fewest failures. Healthy endpoints are compared by batch RTT when both have
+    // sent batches, by probe RTT otherwise. Returns INDEX_NONE if every endpoint is excluded.
+    int32 SelectEndpoint(const TSet<int32>& Exclude) const;
+
+    FString GetBaseUrl(int32 Index) const;
+    int32 Num() const;
+    bool IsHealthy(int32 Index) const;
+
+    // Outcome of a batch sent to the endpoint
+    void ReportSuccess(int32 Index, double RttMs);
+    void ReportFailure(int32 Index);
+
+    void StartProbing();
+    void StopProbing();
+
+private:
+    struct FEndpointState
+    {
+        FString BaseUrl;
+        bool bHealthy = true;
+        double SmoothedBatchRttMs = 0.0; // 0 until measured, so new endpoints get tried early
+        double SmoothedProbeRttMs = 0.0; // Kept apart: a HEAD costs the server far less than a batch
+        int32 ConsecutiveFailures = 0;
+        double NextProbeTime = 0.0;
+        bool bProbeInFlight = false;
+    };
+
+    void ProbeDueEndpoints();
+    void OnProbeComplete(const FString& BaseUrl, bool bReachable, double RttMs);
+    void MarkHealthy(FEndpointState& State);
+
+    mutable FCriticalSection Lock;
+    TArray<FEndpointState> Endpoints;
+    float ProbeInterval = 60.0f;
+    FString ApiKey;
+    FTSTicker::FDelegateHandle ProbeTickerHandle;
+};
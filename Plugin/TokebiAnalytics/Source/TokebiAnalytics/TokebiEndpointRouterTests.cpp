@@ -0,0 +1,283 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsFunctions.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Mocks listen on ROUTING_MOCK_PORT and up; nothing listens on the unreachable port
+static const uint32 ROUTING_MOCK_PORT = 18720;
+static const uint32 ROUTING_UNREACHABLE_PORT = 18729;
+
+// Mock endpoints plus the sandbox they run in. Index i matches the router's endpoint i:
+// the first mock is the API Endpoint, the rest are Additional Ingestion Endpoints.
+struct FTokebiRoutingFixture
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TArray<TSharedRef<FTokebiMockIngestionServer>> Servers;
+
+    int32 TotalTrackRequests() const
+    {
+        int32 Total = 0;
+        for (const TSharedRef<FTokebiMockIngestionServer>& Server : Servers)
+        {
+            Total += Server->TrackRequests;
+        }
+        return Total;
+    }
+};
+
+// Starts a mock per delay, routes the plugin across them and waits until each has been probed,
+// so routing starts from measured RTTs
+static TSharedRef<FTokebiRoutingFixture> StartRoutingFixture(FAutomationTestBase* Test, const TArray<float>& Delays, bool bAddUnreachable = false, float ProbeInterval = 60.0f)
+{
+    TSharedRef<FTokebiRoutingFixture> Fixture = MakeShared<FTokebiRoutingFixture>();
+
+    TArray<FString> Additional;
+    float MaxDelay = 0.0f;
+    for (int32 Index = 0; Index < Delays.Num(); Index++)
+    {
+        TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(ROUTING_MOCK_PORT + Index);
+        Server->DelaySeconds = Delays[Index];
+        MaxDelay = FMath::Max(MaxDelay, Delays[Index]);
+        if (Index > 0)
+        {
+            Additional.Add(Server->GetBaseUrl());
+        }
+        Fixture->Servers.Add(Server);
+    }
+    if (bAddUnreachable)
+    {
+        Additional.Add(FString::Printf(TEXT("http://127.0.0.1:%u"), ROUTING_UNREACHABLE_PORT));
+    }
+
+    Fixture->Environment->SetEndpoints(Fixture->Servers[0]->GetBaseUrl(), Additional, ProbeInterval);
+
+    TokebiAddWaitUntil(Test, TEXT("every endpoint probed"), [Fixture]()
+    {
+        return !Fixture->Servers.ContainsByPredicate([](const TSharedRef<FTokebiMockIngestionServer>& Server) { return Server->ProbeRequests == 0; });
+    });
+    TokebiAddDelay(MaxDelay + 0.5f);
+
+    return Fixture;
+}
+
+static void TrackAndFlush()
+{
+    TMap<FString, FString> EventData;
+    EventData.Add(TEXT("source"), TEXT("routing_test"));
+    UTokebiAnalyticsFunctions::TokebiTrack(TEXT("routing_test"), EventData);
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+}
+
+static bool OfflineEventsSaved()
+{
+    return IFileManager::Get().FileExists(*FTokebiAnalyticsTestAccess::GetOfflineEventsPath());
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingPrefersFastestTest, "TokebiAnalytics.EndpointRouting.PrefersFastest",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingPrefersFastestTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.4f, 0.02f, 0.2f });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Preferred endpoint"), FTokebiAnalyticsTestAccess::GetPreferredEndpoint(), Fixture->Servers[1]->GetBaseUrl());
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch delivered"), [Fixture]() { return Fixture->TotalTrackRequests() > 0 && Fixture->Servers[1]->ReceivedEvents.Num() > 0; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Requests to the slowest endpoint"), Fixture->Servers[0]->TrackRequests, 0);
+        TestEqual(TEXT("Requests to the fastest endpoint"), Fixture->Servers[1]->TrackRequests, 1);
+        TestEqual(TEXT("Requests to the middle endpoint"), Fixture->Servers[2]->TrackRequests, 0);
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingFailoverTest, "TokebiAnalytics.EndpointRouting.Failover",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingFailoverTest::RunTest(const FString& Parameters)
+{
+    // A slow good endpoint, a fast one that turns out to be misconfigured, and one that never answers
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.3f, 0.02f }, true);
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestFalse(TEXT("Unreachable endpoint is unhealthy after probing"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(2));
+
+        Fixture->Servers[1]->ResponseCode = 404;
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch delivered after failover"), [Fixture]() { return Fixture->Servers[0]->ReceivedEvents.Num() > 0; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Requests to the misconfigured endpoint"), Fixture->Servers[1]->TrackRequests, 1);
+        TestEqual(TEXT("Requests to the fallback endpoint"), Fixture->Servers[0]->TrackRequests, 1);
+        TestFalse(TEXT("A 404 marks the endpoint unhealthy"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(1));
+        TestFalse(TEXT("Nothing saved offline"), OfflineEventsSaved());
+        TestEqual(TEXT("Preferred endpoint"), FTokebiAnalyticsTestAccess::GetPreferredEndpoint(), Fixture->Servers[0]->GetBaseUrl());
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingSpillTest, "TokebiAnalytics.EndpointRouting.SpillsOnlyWhenAllFail",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingSpillTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.1f, 0.02f, 0.05f });
+
+    TokebiAddStep([Fixture]()
+    {
+        for (const TSharedRef<FTokebiMockIngestionServer>& Server : Fixture->Servers)
+        {
+            Server->ResponseCode = 503;
+        }
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch saved offline"), [this, Fixture]()
+    {
+        const bool bSaved = OfflineEventsSaved();
+        if (bSaved && Fixture->TotalTrackRequests() < Fixture->Servers.Num())
+        {
+            AddError(FString::Printf(TEXT("Events saved offline after only %d of %d endpoints were tried"), Fixture->TotalTrackRequests(), Fixture->Servers.Num()));
+        }
+        return bSaved;
+    });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        for (const TSharedRef<FTokebiMockIngestionServer>& Server : Fixture->Servers)
+        {
+            TestEqual(TEXT("Requests per endpoint"), Server->TrackRequests, 1);
+        }
+
+        FString SavedJson;
+        TArray<TSharedPtr<FJsonValue>> SavedEvents;
+        FFileHelper::LoadFileToString(SavedJson, *FTokebiAnalyticsTestAccess::GetOfflineEventsPath());
+        FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(SavedJson), SavedEvents);
+        TestEqual(TEXT("Events saved offline"), SavedEvents.Num(), 1);
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingProbeRecoveryTest, "TokebiAnalytics.EndpointRouting.ProbeRecovery",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingProbeRecoveryTest::RunTest(const FString& Parameters)
+{
+    // Short probe interval so the failed endpoint is re-checked within the test
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.3f, 0.02f }, false, 1.0f);
+
+    TokebiAddStep([Fixture]()
+    {
+        Fixture->Servers[1]->ResponseCode = 500;
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch delivered after failover"), [Fixture]() { return Fixture->Servers[0]->ReceivedEvents.Num() > 0; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestFalse(TEXT("Failed endpoint is unhealthy"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(1));
+        Fixture->Servers[1]->ResponseCode = 200;
+    });
+
+    TokebiAddWaitUntil(this, TEXT("probe marks the endpoint healthy again"), []() { return FTokebiAnalyticsTestAccess::IsEndpointHealthy(1); });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Preferred endpoint"), FTokebiAnalyticsTestAccess::GetPreferredEndpoint(), Fixture->Servers[1]->GetBaseUrl());
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch delivered to the recovered endpoint"), [Fixture]() { return Fixture->Servers[1]->ReceivedEvents.Num() > 0; });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingPostOnlyTest, "TokebiAnalytics.EndpointRouting.PostOnlyEndpointsStayHealthy",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingPostOnlyTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.2f, 0.02f }, false, 1.0f);
+
+    // Ingestion services that only route POST answer the HEAD probe with 405
+    TokebiAddStep([Fixture]()
+    {
+        for (const TSharedRef<FTokebiMockIngestionServer>& Server : Fixture->Servers)
+        {
+            Server->ProbeResponseCode = 405;
+            Server->ProbeRequests = 0;
+        }
+    });
+
+    TokebiAddWaitUntil(this, TEXT("every endpoint probed twice"), [Fixture]()
+    {
+        return !Fixture->Servers.ContainsByPredicate([](const TSharedRef<FTokebiMockIngestionServer>& Server) { return Server->ProbeRequests < 2; });
+    });
+    TokebiAddDelay(0.5f);
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestTrue(TEXT("Slow endpoint healthy"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(0));
+        TestTrue(TEXT("Fast endpoint healthy"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(1));
+        TestEqual(TEXT("Preferred endpoint"), FTokebiAnalyticsTestAccess::GetPreferredEndpoint(), Fixture->Servers[1]->GetBaseUrl());
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch delivered"), [Fixture]() { return Fixture->Servers[1]->ReceivedEvents.Num() > 0; });
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Requests to the slow endpoint"), Fixture->Servers[0]->TrackRequests, 0);
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiRoutingPayloadRejectionTest, "TokebiAnalytics.EndpointRouting.PayloadRejectionDoesNotFailOver",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiRoutingPayloadRejectionTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiRoutingFixture> Fixture = StartRoutingFixture(this, { 0.2f, 0.02f });
+
+    // Every endpoint would reject the same payload, so trying the next one only doubles the load
+    TokebiAddStep([Fixture]()
+    {
+        Fixture->Servers[1]->ResponseCode = 413;
+        TrackAndFlush();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("batch rejected"), [Fixture]() { return Fixture->Servers[1]->TrackRequests > 0; });
+    TokebiAddDelay(1.0f);
+
+    TokebiAddStep([this, Fixture]()
+    {
+        TestEqual(TEXT("Requests to the rejecting endpoint"), Fixture->Servers[1]->TrackRequests, 1);
+        TestEqual(TEXT("Requests to the other endpoint"), Fixture->Servers[0]->TrackRequests, 0);
+        TestTrue(TEXT("A rejected payload leaves the endpoint healthy"), FTokebiAnalyticsTestAccess::IsEndpointHealthy(1));
+    });
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
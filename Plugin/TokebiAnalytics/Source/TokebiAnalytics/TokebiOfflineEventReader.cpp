@@ -0,0 +1,270 @@
+#include "TokebiOfflineEventReader.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTokebiAnalytics, Log, All);
+
+// Builds one JSON value from the reader's token stream, starting at an already-read notation.
+// Used instead of FJsonSerializer::Deserialize so we can stop after each array element.
+template <typename CharType>
+static TSharedPtr<FJsonValue> ReadJsonValue(TJsonReader<CharType>& Reader, EJsonNotation Notation)
+{
+    switch (Notation)
+    {
+    case EJsonNotation::ObjectStart:
+        {
+            TSharedPtr<FJsonObject> Object = MakeShareable(new FJsonObject);
+            EJsonNotation Child;
+            while (Reader.ReadNext(Child))
+            {
+                if (Child == EJsonNotation::ObjectEnd)
+                {
+                    return MakeShareable(new FJsonValueObject(Object));
+                }
+
+                // Grab the key before recursing, nested values overwrite it
+                const FString Key = Reader.GetIdentifier();
+                TSharedPtr<FJsonValue> Value = ReadJsonValue(Reader, Child);
+                if (!Value.IsValid())
+                {
+                    return nullptr;
+                }
+                Object->SetField(Key, Value);
+            }
+            return nullptr;
+        }
+    case EJsonNotation::ArrayStart:
+        {
+            TArray<TSharedPtr<FJsonValue>> Array;
+            EJsonNotation Child;
+            while (Reader.ReadNext(Child))
+            {
+                if (Child == EJsonNotation::ArrayEnd)
+                {
+                    return MakeShareable(new FJsonValueArray(Array));
+                }
+
+                TSharedPtr<FJsonValue> Value = ReadJsonValue(Reader, Child);
+                if (!Value.IsValid())
+                {
+                    return nullptr;
+                }
+                Array.Add(Value);
+            }
+            return nullptr;
+        }
+    case EJsonNotation::String:
+        return MakeShareable(new FJsonValueString(Reader.GetValueAsString()));
+    case EJsonNotation::Number:
+        return MakeShareable(new FJsonValueNumber(Reader.GetValueAsNumber()));
+    case EJsonNotation::Boolean:
+        return MakeShareable(new FJsonValueBoolean(Reader.GetValueAsBoolean()));
+    case EJsonNotation::Null:
+        return MakeShareable(new FJsonValueNull());
+    default:
+        return nullptr;
+    }
+}
+
+// The JSON array format written by SaveEventsToFile
+class FTokebiJsonArrayEventReader : public FTokebiOfflineEventReader
+{
+public:
+    explicit FTokebiJsonArrayEventReader(FArchive* InArchive)
+        : Archive(InArchive)
+    {
+        // FFileHelper::SaveStringToFile writes plain ANSI, or UTF-16LE with a BOM if the text needs it
+        uint8 Bom[3] = { 0, 0, 0 };
+        Archive->Serialize(Bom, FMath::Min<int64>(3, Archive->TotalSize()));
+
+        if (Bom[0] == 0xFF && Bom[1] == 0xFE)
+        {
+            Archive->Seek(2);
+            WideReader = TJsonReaderFactory<TCHAR>::Create(Archive.Get());
+        }
+        else
+        {
+            Archive->Seek(Bom[0] == 0xEF && Bom[1] == 0xBB && Bom[2] == 0xBF ? 3 : 0);
+            AnsiReader = TJsonReaderFactory<ANSICHAR>::Create(Archive.Get());
+        }
+    }
+
+    virtual bool ReadNext(TSharedPtr<FJsonObject>& OutEvent) override
+    {
+        if (bFinished || bError)
+        {
+            return false;
+        }
+
+        return WideReader.IsValid() ? ReadNextFrom(*WideReader, OutEvent) : ReadNextFrom(*AnsiReader, OutEvent);
+    }
+
+    virtual bool HasError() const override { return bError; }
+    virtual int64 GetBytesRead() const override { return Archive->Tell(); }
+    virtual int64 GetTotalBytes() const override { return Archive->TotalSize(); }
+
+private:
+    template <typename CharType>
+    bool ReadNextFrom(TJsonReader<CharType>& Reader, TSharedPtr<FJsonObject>& OutEvent)
+    {
+        EJsonNotation Notation;
+        while (Reader.ReadNext(Notation))
+        {
+            if (!bStarted)
+            {
+                if (Notation != EJsonNotation::ArrayStart)
+                {
+                    break;
+                }
+                bStarted = true;
+                continue;
+            }
+
+            if (Notation == EJsonNotation::ArrayEnd)
+            {
+                bFinished = true;
+                return false;
+            }
+
+            TSharedPtr<FJsonValue> Value = ReadJsonValue(Reader, Notation);
+            if (!Value.IsValid())
+            {
+                break;
+            }
+
+            // Non-object entries are skipped, same as LoadEventsFromFile
+            if (Value->Type == EJson::Object)
+            {
+                OutEvent = Value->AsObject();
+                return true;
+            }
+        }
+
+        // Ran out of tokens before the closing bracket - the store is corrupt or was cut off mid-write
+        UE_LOG(LogTokebiAnalytics, Warning, TEXT("Offline event store ended unexpectedly at byte %lld: %s"),
+               Archive->Tell(), *Reader.GetErrorMessage());
+        bError = true;
+        return false;
+    }
+
+    TUniquePtr<FArchive> Archive;
+    TSharedPtr<TJsonReader<ANSICHAR>> AnsiReader;
+    TSharedPtr<TJsonReader<TCHAR>> WideReader;
+    bool bStarted = false;
+    bool bFinished = false;
+    bool bError = false;
+};
+
+// Newline-delimited JSON, one event object per line (UTF-8)
+class FTokebiNdjsonEventReader : public FTokebiOfflineEventReader
+{
+public:
+    explicit FTokebiNdjsonEventReader(FArchive* InArchive)
+        : Archive(InArchive)
+    {
+    }
+
+    virtual bool ReadNext(TSharedPtr<FJsonObject>& OutEvent) override
+    {
+        FString Line;
+        while (ReadLine(Line))
+        {
+            Line.TrimStartAndEndInline();
+            if (Line.IsEmpty())
+            {
+                continue;
+            }
+
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Line);
+            if (FJsonSerializer::Deserialize(Reader, OutEvent) && OutEvent.IsValid())
+            {
+                return true;
+            }
+
+            // A bad line only loses that event, the rest of the store is still usable
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Skipping unparseable line ending at byte %lld"), GetBytesRead());
+        }
+        return false;
+    }
+
+    virtual bool HasError() const override { return false; }
+    virtual int64 GetBytesRead() const override { return Archive->Tell() - (Buffer.Num() - BufferPos); }
+    virtual int64 GetTotalBytes() const override { return Archive->TotalSize(); }
+
+private:
+    bool ReadLine(FString& OutLine)
+    {
+        static const int32 CHUNK_SIZE = 64 * 1024;
+
+        LineBytes.Reset();
+        for (;;)
+        {
+            if (BufferPos == Buffer.Num())
+            {
+                const int64 Remaining = Archive->TotalSize() - Archive->Tell();
+                if (Remaining <= 0)
+                {
+                    break;
+                }
+
+                Buffer.SetNumUninitialized((int32)FMath::Min<int64>(CHUNK_SIZE, Remaining));
+                Archive->Serialize(Buffer.GetData(), Buffer.Num());
+                BufferPos = 0;
+
+                // Skip a UTF-8 BOM at the start of the file
+                if (Archive->Tell() == Buffer.Num() && Buffer.Num() >= 3 && Buffer[0] == 0xEF && Buffer[1] == 0xBB && Buffer[2] == 0xBF)
+                {
+                    BufferPos = 3;
+                }
+            }
+
+            const int32 Start = BufferPos;
+            while (BufferPos < Buffer.Num() && Buffer[BufferPos] != '\n')
+            {
+                BufferPos++;
+            }
+            LineBytes.Append(Buffer.GetData() + Start, BufferPos - Start);
+
+            if (BufferPos < Buffer.Num())
+            {
+                BufferPos++; // Consume the newline
+                break;
+            }
+        }
+
+        if (LineBytes.Num() == 0 && BufferPos == Buffer.Num() && Archive->Tell() >= Archive->TotalSize())
+        {
+            return false;
+        }
+
+        FUTF8ToTCHAR Converter((const ANSICHAR*)LineBytes.GetData(), LineBytes.Num());
+        OutLine = FString(Converter.Length(), Converter.Get());
+        return true;
+    }
+
+    TUniquePtr<FArchive> Archive;
+    TArray<uint8> Buffer;
+    TArray<uint8> LineBytes;
+    int32 BufferPos = 0;
+};
+
+TUniquePtr<FTokebiOfflineEventReader> FTokebiOfflineEventReader::Open(const FString& FilePath)
+{
+    FArchive* Archive = IFileManager::Get().CreateFileReader(*FilePath);
+    if (!Archive)
+    {
+        UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ Failed to open offline event store: %s"), *FilePath);
+        return nullptr;
+    }
+
+    const FString Extension = FPaths::GetExtension(FilePath);
+    if (Extension == TEXT("ndjson") || Extension == TEXT("jsonl"))
+    {
+        return MakeUnique<FTokebiNdjsonEventReader>(Archive);
+    }
+    return MakeUnique<FTokebiJsonArrayEventReader>(Archive);
+}
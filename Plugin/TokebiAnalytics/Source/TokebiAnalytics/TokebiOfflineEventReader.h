@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+/**
+ * Streams events out of an offline event store one at a time, so stores of any size
+ * can be processed in bounded memory. Supports the JSON array written by
+ * UTokebiAnalyticsFunctions::SaveEventsToFile and newline-delimited JSON (.ndjson/.jsonl).
+ */
+class TOKEBIANALYTICS_API FTokebiOfflineEventReader
+{
+public:
+    virtual ~FTokebiOfflineEventReader() {}
+
+    // Reads the next event. Returns false at the end of the store or when it can't be parsed further.
+    virtual bool ReadNext(TSharedPtr<FJsonObject>& OutEvent) = 0;
+
+    // True if reading stopped early because the store is corrupt or truncated
+    virtual bool HasError() const = 0;
+
+    virtual int64 GetBytesRead() const = 0;
+    virtual int64 GetTotalBytes() const = 0;
+
+    // Opens a store, picking the format from the file extension. Returns null if the file can't be opened.
+    static TUniquePtr<FTokebiOfflineEventReader> Open(const FString& FilePath);
+};
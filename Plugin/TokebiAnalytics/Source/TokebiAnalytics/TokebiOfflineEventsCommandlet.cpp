@@ -0,0 +1,637 @@
+#include "TokebiOfflineEventsCommandlet.h"
+#include "TokebiOfflineEventReader.h"
+#include "TokebiAnalyticsFunctions.h"
+#include "TokebiAnalyticsSettings.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/CityHash.h"
+#include "Containers/Ticker.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogTokebiAnalytics, Log, All);
+
+// Constants
+static const int32 DEFAULT_BATCH_SIZE = 1000;
+static const int32 DEFAULT_MAX_IN_FLIGHT = 4;
+static const int32 DEFAULT_DEDUP_WINDOW = 4000000;  // ~100 MB of hashes at most, with -DedupContent
+static const int32 MAX_UPLOAD_ATTEMPTS = 5;
+static const int64 EXPORT_PROGRESS_INTERVAL = 10000; // Events between progress saves when exporting
+static const int64 LOG_PROGRESS_INTERVAL = 100000;   // Events between progress log lines
+
+static FString SerializeEvent(const TSharedPtr<FJsonObject>& Event)
+{
+    FString JsonString;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+    FJsonSerializer::Serialize(Event.ToSharedRef(), Writer);
+    return JsonString;
+}
+
+static int64 GetUnixTimeMs()
+{
+    return (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+}
+
+// Remembers the hashes of the most recent events; the oldest are forgotten once full
+// so memory stays bounded no matter how large the stores are
+class FTokebiDedupWindow
+{
+public:
+    explicit FTokebiDedupWindow(int32 InCapacity)
+        : Capacity(InCapacity)
+    {
+    }
+
+    // Returns false if the hash is already in the window
+    bool AddUnique(uint64 Hash)
+    {
+        if (Capacity <= 0)
+        {
+            return true;
+        }
+
+        if (Hashes.Contains(Hash))
+        {
+            return false;
+        }
+
+        if (Order.Num() < Capacity)
+        {
+            Order.Add(Hash);
+        }
+        else
+        {
+            Hashes.Remove(Order[NextEvict]);
+            Order[NextEvict] = Hash;
+            NextEvict = (NextEvict + 1) % Capacity;
+        }
+        Hashes.Add(Hash);
+        return true;
+    }
+
+private:
+    int32 Capacity;
+    TSet<uint64> Hashes;
+    TArray<uint64> Order;
+    int32 NextEvict = 0;
+};
+
+// Resume state: how many events of each input have been fully handled, and how much of the
+// export file is known to be good. Mode and Target record which run wrote it, so an upload
+// never resumes from an export's progress or vice versa.
+struct FTokebiOfflineProgress
+{
+    FString Mode;
+    FString Target;
+    TMap<FString, int64> EventsDone;
+    int64 OutputBytes = 0;
+
+    bool Load(const FString& FilePath)
+    {
+        FString JsonString;
+        TSharedPtr<FJsonObject> JsonObject;
+        if (!FFileHelper::LoadFileToString(JsonString, *FilePath) ||
+            !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), JsonObject) || !JsonObject.IsValid())
+        {
+            return false;
+        }
+
+        Mode = JsonObject->GetStringField(TEXT("mode"));
+        Target = JsonObject->GetStringField(TEXT("target"));
+        OutputBytes = (int64)JsonObject->GetNumberField(TEXT("outputBytes"));
+        const TSharedPtr<FJsonObject>* InputsObject = nullptr;
+        if (JsonObject->TryGetObjectField(TEXT("inputs"), InputsObject))
+        {
+            for (const auto& Pair : (*InputsObject)->Values)
+            {
+                EventsDone.Add(Pair.Key, (int64)Pair.Value->AsNumber());
+            }
+        }
+        return true;
+    }
+
+    void Save(const FString& FilePath) const
+    {
+        TSharedPtr<FJsonObject> InputsObject = MakeShareable(new FJsonObject);
+        for (const auto& Pair : EventsDone)
+        {
+            InputsObject->SetNumberField(Pair.Key, (double)Pair.Value);
+        }
+
+        TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+        JsonObject->SetStringField(TEXT("mode"), Mode);
+        JsonObject->SetStringField(TEXT("target"), Target);
+        JsonObject->SetNumberField(TEXT("outputBytes"), (double)OutputBytes);
+        JsonObject->SetObjectField(TEXT("inputs"), InputsObject);
+
+        FString JsonString;
+        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+        FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
+
+        if (!FFileHelper::SaveStringToFile(JsonString, *FilePath))
+        {
+            UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ Failed to save progress file: %s"), *FilePath);
+        }
+    }
+};
+
+// One upload request and the input position it covers
+struct FTokebiUploadBatch
+{
+    FString InputPath;
+    int64 EndEventIndex = 0;
+    FString Payload;
+    int32 Attempts = 0;
+    double RetryAtTime = 0.0;
+    bool bInFlight = false;
+    bool bAcked = false;
+    int32 RejectedCode = 0; // Set when the endpoint refused the batch in a way retrying can't fix
+};
+
+// Bad payload, bad API key or a batch too large: every retry would get the same answer
+static bool IsPermanentRejection(int32 ResponseCode)
+{
+    return ResponseCode == EHttpResponseCodes::BadRequest ||
+           ResponseCode == EHttpResponseCodes::Denied ||
+           ResponseCode == EHttpResponseCodes::Forbidden ||
+           ResponseCode == EHttpResponseCodes::RequestTooLarge;
+}
+
+// Keeps several batches in flight. Progress only advances over the contiguous prefix of
+// acknowledged batches, so an interrupted run resumes without losing or skipping events.
+class FTokebiBatchUploader
+{
+public:
+    FTokebiBatchUploader(const FString& InTrackUrl, const FString& InApiKey, int32 InMaxInFlight,
+                         FTokebiOfflineProgress& InProgress, const FString& InProgressPath)
+        : TrackUrl(InTrackUrl)
+        , ApiKey(InApiKey)
+        , MaxInFlight(FMath::Max(InMaxInFlight, 1))
+        , Progress(InProgress)
+        , ProgressPath(InProgressPath)
+    {
+    }
+
+    // Queues a batch, pumping HTTP until there's a free slot. Returns false if uploading had to stop.
+    bool Submit(const TSharedPtr<FTokebiUploadBatch>& Batch)
+    {
+        while (Window.Num() >= MaxInFlight)
+        {
+            if (!Pump())
+            {
+                return false;
+            }
+        }
+
+        Window.Add(Batch);
+        if (!Batch->bAcked)
+        {
+            Send(Batch);
+        }
+        return true;
+    }
+
+    // Waits for every submitted batch to be acknowledged
+    bool Drain()
+    {
+        while (Window.Num() > 0)
+        {
+            if (!Pump())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int64 GetBytesSent() const { return BytesSent; }
+
+private:
+    bool Pump()
+    {
+        // Retire the acknowledged prefix
+        bool bRetired = false;
+        while (Window.Num() > 0 && Window[0]->bAcked)
+        {
+            Progress.EventsDone.Add(Window[0]->InputPath, Window[0]->EndEventIndex);
+            Window.RemoveAt(0);
+            bRetired = true;
+        }
+        if (bRetired)
+        {
+            Progress.Save(ProgressPath);
+        }
+
+        const double Now = FPlatformTime::Seconds();
+        for (const TSharedPtr<FTokebiUploadBatch>& Batch : Window)
+        {
+            if (Batch->RejectedCode != 0)
+            {
+                UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ Endpoint rejected batch ending at event %lld of %s (response code: %d), stopping"),
+                       Batch->EndEventIndex, *Batch->InputPath, Batch->RejectedCode);
+                return false;
+            }
+
+            if (!Batch->bAcked && !Batch->bInFlight && Now >= Batch->RetryAtTime)
+            {
+                if (Batch->Attempts >= MAX_UPLOAD_ATTEMPTS)
+                {
+                    UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ Giving up on batch ending at event %lld of %s after %d attempts"),
+                           Batch->EndEventIndex, *Batch->InputPath, Batch->Attempts);
+                    return false;
+                }
+                Send(Batch);
+            }
+        }
+
+        // No game loop in a commandlet, so drive the HTTP manager ourselves
+        const double TickTime = FPlatformTime::Seconds();
+        FTSTicker::GetCoreTicker().Tick((float)(TickTime - LastTickTime));
+        LastTickTime = TickTime;
+        FPlatformProcess::Sleep(0.005f);
+        return true;
+    }
+
+    void Send(const TSharedPtr<FTokebiUploadBatch>& Batch)
+    {
+        TSharedRef<IHttpRequest> HttpRequest = FHttpModule::Get().CreateRequest();
+        HttpRequest->SetVerb(TEXT("POST"));
+        HttpRequest->SetURL(TrackUrl);
+        HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+        HttpRequest->SetHeader(TEXT("Authorization"), ApiKey);
+        HttpRequest->SetContentAsString(Batch->Payload);
+
+        Batch->bInFlight = true;
+        Batch->Attempts++;
+
+        HttpRequest->OnProcessRequestComplete().BindLambda([Batch](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+        {
+            Batch->bInFlight = false;
+            const int32 ResponseCode = bWasSuccessful && Response.IsValid() ? Response->GetResponseCode() : 0;
+            if (EHttpResponseCodes::IsOk(ResponseCode))
+            {
+                Batch->bAcked = true;
+                Batch->Payload.Empty();
+                return;
+            }
+
+            if (IsPermanentRejection(ResponseCode))
+            {
+                Batch->RejectedCode = ResponseCode;
+                return;
+            }
+
+            // Exponential backoff: 1, 2, 4, 8... seconds
+            Batch->RetryAtTime = FPlatformTime::Seconds() + FMath::Min(30.0, FMath::Pow(2.0, (double)(Batch->Attempts - 1)));
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Upload attempt %d failed (response code: %d), retrying"),
+                   Batch->Attempts, ResponseCode);
+        });
+
+        BytesSent += Batch->Payload.Len();
+        if (!HttpRequest->ProcessRequest())
+        {
+            Batch->bInFlight = false;
+            Batch->RetryAtTime = FPlatformTime::Seconds() + 1.0;
+        }
+    }
+
+    FString TrackUrl;
+    FString ApiKey;
+    int32 MaxInFlight;
+    FTokebiOfflineProgress& Progress;
+    FString ProgressPath;
+    TArray<TSharedPtr<FTokebiUploadBatch>> Window;
+    double LastTickTime = FPlatformTime::Seconds();
+    int64 BytesSent = 0;
+};
+
+UTokebiOfflineEventsCommandlet::UTokebiOfflineEventsCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UTokebiOfflineEventsCommandlet::Main(const FString& Params)
+{
+    const UTokebiAnalyticsSettings* Settings = GetDefault<UTokebiAnalyticsSettings>();
+
+    FString ExportPath;
+    const bool bExport = FParse::Value(*Params, TEXT("Export="), ExportPath);
+    const bool bUpload = FParse::Param(*Params, TEXT("Upload"));
+    if (bExport == bUpload)
+    {
+        UE_LOG(LogTokebiAnalytics, Error, TEXT("Specify exactly one of -Export=<file.ndjson> or -Upload"));
+        return 1;
+    }
+
+    // Gather inputs, expanding directories into the stores they contain
+    TArray<FString> InputPaths;
+    FString InputParam;
+    if (FParse::Value(*Params, TEXT("Input="), InputParam))
+    {
+        TArray<FString> Entries;
+        InputParam.ParseIntoArray(Entries, TEXT("+"));
+        for (const FString& Entry : Entries)
+        {
+            if (!IFileManager::Get().DirectoryExists(*Entry))
+            {
+                InputPaths.Add(FPaths::ConvertRelativePathToFull(Entry));
+                continue;
+            }
+
+            TArray<FString> Found;
+            for (const TCHAR* Extension : { TEXT("json"), TEXT("ndjson"), TEXT("jsonl") })
+            {
+                TArray<FString> FileNames;
+                IFileManager::Get().FindFiles(FileNames, *Entry, Extension);
+                for (const FString& FileName : FileNames)
+                {
+                    const FString FilePath = FPaths::ConvertRelativePathToFull(Entry / FileName);
+                    if (!bExport || !FPaths::IsSamePath(FilePath, ExportPath))
+                    {
+                        Found.Add(FilePath);
+                    }
+                }
+            }
+            Found.Sort();
+            InputPaths.Append(Found);
+        }
+    }
+    else
+    {
+        InputPaths.Add(UTokebiAnalyticsFunctions::GetOfflineEventsPath());
+    }
+
+    // Overlapping inputs (a store and its directory, or one store listed twice) are the same
+    // events ingested again, so each store is only read once
+    TArray<FString> UniqueInputPaths;
+    for (const FString& InputPath : InputPaths)
+    {
+        if (UniqueInputPaths.ContainsByPredicate([&InputPath](const FString& Existing) { return FPaths::IsSamePath(Existing, InputPath); }))
+        {
+            UE_LOG(LogTokebiAnalytics, Log, TEXT("Skipping %s, already listed"), *InputPath);
+            continue;
+        }
+        UniqueInputPaths.Add(InputPath);
+    }
+    InputPaths = MoveTemp(UniqueInputPaths);
+
+    if (InputPaths.Num() == 0)
+    {
+        UE_LOG(LogTokebiAnalytics, Error, TEXT("No offline event stores found"));
+        return 1;
+    }
+
+    int32 BatchSize = DEFAULT_BATCH_SIZE;
+    int32 MaxInFlight = DEFAULT_MAX_IN_FLIGHT;
+    int32 DedupWindowSize = DEFAULT_DEDUP_WINDOW;
+    FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+    FParse::Value(*Params, TEXT("MaxInFlight="), MaxInFlight);
+    FParse::Value(*Params, TEXT("DedupWindow="), DedupWindowSize);
+    const bool bDedupContent = FParse::Param(*Params, TEXT("DedupContent"));
+    BatchSize = FMath::Max(BatchSize, 1);
+
+    // Upload target
+    FString Endpoint = Settings->TokebiEndpoint;
+    FString ApiKey = Settings->TokebiApiKey;
+    if (bUpload)
+    {
+        FParse::Value(*Params, TEXT("Endpoint="), Endpoint);
+        FParse::Value(*Params, TEXT("ApiKey="), ApiKey);
+        if (Endpoint.IsEmpty() || ApiKey.IsEmpty())
+        {
+            UE_LOG(LogTokebiAnalytics, Error, TEXT("Uploading needs an endpoint and API key (settings or -Endpoint= / -ApiKey=)"));
+            return 1;
+        }
+    }
+
+    const FString Mode = bExport ? TEXT("export") : TEXT("upload");
+    const FString Target = bExport ? FPaths::ConvertRelativePathToFull(ExportPath) : Endpoint + TEXT("/api/track");
+
+    // Separate default files per mode, so exporting and uploading the same stores can't clash
+    FString ProgressPath = FPaths::ProjectSavedDir() / TEXT("Analytics") / FString::Printf(TEXT("TokebiOfflineEvents.%s.progress"), *Mode);
+    FParse::Value(*Params, TEXT("Progress="), ProgressPath);
+
+    FTokebiOfflineProgress Progress;
+    if (FParse::Param(*Params, TEXT("Resume")))
+    {
+        if (!Progress.Load(ProgressPath))
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("No usable progress file at %s, starting from the beginning"), *ProgressPath);
+            Progress = FTokebiOfflineProgress();
+        }
+        else if (Progress.Mode != Mode || Progress.Target != Target)
+        {
+            UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ %s was saved by an %s to %s, not this %s to %s. Use a different -Progress= or drop -Resume."),
+                   *ProgressPath, *Progress.Mode, *Progress.Target, *Mode, *Target);
+            return 1;
+        }
+        else
+        {
+            UE_LOG(LogTokebiAnalytics, Log, TEXT("Resuming from %s"), *ProgressPath);
+        }
+    }
+    Progress.Mode = Mode;
+    Progress.Target = Target;
+
+    // Export output. On resume, cut off anything written after the last saved progress.
+    TUniquePtr<IFileHandle> Output;
+    if (bExport)
+    {
+        IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        PlatformFile.CreateDirectoryTree(*FPaths::GetPath(ExportPath));
+        Output.Reset(PlatformFile.OpenWrite(*ExportPath, Progress.OutputBytes > 0));
+        if (!Output)
+        {
+            UE_LOG(LogTokebiAnalytics, Error, TEXT("❌ Failed to open export file: %s"), *ExportPath);
+            return 1;
+        }
+
+        if (Output->Size() < Progress.OutputBytes)
+        {
+            UE_LOG(LogTokebiAnalytics, Warning, TEXT("Export file is shorter than the saved progress, starting from the beginning"));
+            Progress.EventsDone.Empty();
+            Progress.OutputBytes = 0;
+        }
+        Output->Truncate(Progress.OutputBytes);
+        Output->SeekFromEnd(0);
+    }
+
+    TUniquePtr<FTokebiBatchUploader> Uploader;
+    if (bUpload)
+    {
+        Uploader = MakeUnique<FTokebiBatchUploader>(Endpoint + TEXT("/api/track"), ApiKey, MaxInFlight, Progress, ProgressPath);
+        UE_LOG(LogTokebiAnalytics, Log, TEXT("Uploading to %s/api/track (batch size %d, %d in flight)"), *Endpoint, BatchSize, MaxInFlight);
+    }
+
+    FTokebiDedupWindow Dedup(bDedupContent ? DedupWindowSize : 0);
+    int64 TotalRead = 0;
+    int64 TotalDuplicates = 0;
+    int64 TotalWritten = 0;
+    bool bHadErrors = false;
+
+    for (const FString& InputPath : InputPaths)
+    {
+        TUniquePtr<FTokebiOfflineEventReader> Reader = FTokebiOfflineEventReader::Open(InputPath);
+        if (!Reader)
+        {
+            bHadErrors = true;
+            continue;
+        }
+
+        const int64 AlreadyDone = Progress.EventsDone.FindRef(InputPath);
+        UE_LOG(LogTokebiAnalytics, Log, TEXT("Processing %s (%.1f MB, %lld events already done)"),
+               *InputPath, Reader->GetTotalBytes() / (1024.0 * 1024.0), AlreadyDone);
+
+        TSharedPtr<FTokebiUploadBatch> Batch;
+        int64 EventsSinceSave = 0;
+        int32 BatchEvents = 0;
+        int64 BatchSentAtMs = 0;
+        int64 EventIndex = 0;
+        TSharedPtr<FJsonObject> Event;
+
+        while (Reader->ReadNext(Event))
+        {
+            EventIndex++;
+            TotalRead++;
+
+            // Events handled by an earlier run are still hashed so duplicates of them are caught
+            const FString EventJson = SerializeEvent(Event);
+            const bool bUnique = !bDedupContent || Dedup.AddUnique(CityHash64((const char*)*EventJson, EventJson.Len() * sizeof(TCHAR)));
+            if (EventIndex <= AlreadyDone)
+            {
+                continue;
+            }
+            if (!bUnique)
+            {
+                TotalDuplicates++;
+            }
+            else if (Output)
+            {
+                FTCHARToUTF8 Utf8(*EventJson);
+                Output->Write((const uint8*)Utf8.Get(), Utf8.Length());
+                Output->Write((const uint8*)"\n", 1);
+            }
+            else
+            {
+                if (!Batch.IsValid())
+                {
+                    Batch = MakeShareable(new FTokebiUploadBatch);
+                    Batch->InputPath = InputPath;
+                    BatchSentAtMs = GetUnixTimeMs();
+                    Batch->Payload = FString::Printf(TEXT("{\"sentAt\":%lld,\"events\":["), BatchSentAtMs);
+                    BatchEvents = 0;
+                }
+
+                // Saved events carry absolute timestamps; the track API wants an offset from sentAt
+                double TimestampMs = 0.0;
+                if (Event->TryGetNumberField(TEXT("timestamp"), TimestampMs))
+                {
+                    Event->RemoveField(TEXT("timestamp"));
+                    Event->SetNumberField(TEXT("timeOffsetMs"), (double)((int64)TimestampMs - BatchSentAtMs));
+                }
+                if (Event->TryGetNumberField(TEXT("lastTimestamp"), TimestampMs))
+                {
+                    Event->RemoveField(TEXT("lastTimestamp"));
+                    Event->SetNumberField(TEXT("lastTimeOffsetMs"), (double)((int64)TimestampMs - BatchSentAtMs));
+                }
+
+                if (BatchEvents > 0)
+                {
+                    Batch->Payload += TEXT(",");
+                }
+                Batch->Payload += SerializeEvent(Event);
+                BatchEvents++;
+
+                if (BatchEvents >= BatchSize)
+                {
+                    Batch->Payload += TEXT("]}");
+                    Batch->EndEventIndex = EventIndex;
+                    if (!Uploader->Submit(Batch))
+                    {
+                        return 1;
+                    }
+                    Batch.Reset();
+                }
+            }
+
+            // Count every event read, duplicates included, so long runs of them still get checkpointed
+            if (Output && ++EventsSinceSave >= EXPORT_PROGRESS_INTERVAL)
+            {
+                Output->Flush();
+                Progress.OutputBytes = Output->Tell();
+                Progress.EventsDone.Add(InputPath, EventIndex);
+                Progress.Save(ProgressPath);
+                EventsSinceSave = 0;
+            }
+
+            if (!bUnique)
+            {
+                continue;
+            }
+
+            TotalWritten++;
+            if (TotalWritten % LOG_PROGRESS_INTERVAL == 0)
+            {
+                UE_LOG(LogTokebiAnalytics, Log, TEXT("%lld events processed (%.1f / %.1f MB of %s)"), TotalWritten,
+                       Reader->GetBytesRead() / (1024.0 * 1024.0), Reader->GetTotalBytes() / (1024.0 * 1024.0), *FPaths::GetCleanFilename(InputPath));
+            }
+        }
+
+        bHadErrors |= Reader->HasError();
+
+        // Finish the input. An empty batch still goes through the uploader so progress
+        // covers trailing duplicates once everything before them is acknowledged.
+        if (Output)
+        {
+            Output->Flush();
+            Progress.OutputBytes = Output->Tell();
+            Progress.EventsDone.Add(InputPath, FMath::Max(EventIndex, AlreadyDone));
+            Progress.Save(ProgressPath);
+        }
+        else
+        {
+            if (!Batch.IsValid())
+            {
+                Batch = MakeShareable(new FTokebiUploadBatch);
+                Batch->InputPath = InputPath;
+                Batch->bAcked = true;
+            }
+            else
+            {
+                Batch->Payload += TEXT("]}");
+            }
+            Batch->EndEventIndex = FMath::Max(EventIndex, AlreadyDone);
+            if (!Uploader->Submit(Batch))
+            {
+                return 1;
+            }
+        }
+    }
+
+    if (Uploader && !Uploader->Drain())
+    {
+        return 1;
+    }
+
+    UE_LOG(LogTokebiAnalytics, Log, TEXT("✅ Done: %lld events read, %lld duplicates dropped, %lld %s"),
+           TotalRead, TotalDuplicates, TotalWritten, bExport ? *FString::Printf(TEXT("exported to %s"), *ExportPath) : TEXT("uploaded"));
+    if (Uploader)
+    {
+        UE_LOG(LogTokebiAnalytics, Log, TEXT("Upload volume: %.1f MB"), Uploader->GetBytesSent() / (1024.0 * 1024.0));
+    }
+
+    return bHadErrors ? 1 : 0;
+}
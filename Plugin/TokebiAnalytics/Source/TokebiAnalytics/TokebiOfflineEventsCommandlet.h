@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TokebiOfflineEventsCommandlet.generated.h"
+
+/**
+ * Recovers offline event stores (e.g. from QA or kiosk machines that ran offline for days)
+ * without launching the game. Stores are streamed, so multi-gigabyte collections are
+ * processed in bounded memory.
+ *
+ * Usage:
+ *   -run=TokebiOfflineEvents [-Input=<file|dir>[+<file|dir>...]] (-Export=<out.ndjson> | -Upload)
+ *
+ * Options:
+ *   -Input=         Stores or directories of stores (*.json, *.ndjson, *.jsonl). Defaults to the project's TokebiOfflineEvents.json.
+ *                   A store listed more than once (directly or through a directory) is read once
+ *   -Export=        Write all events to an NDJSON file
+ *   -Upload         Send events to the track endpoint
+ *   -Endpoint=      Base URL to upload to (defaults to the API Endpoint setting)
+ *   -ApiKey=        API key to upload with (defaults to the API Key setting)
+ *   -BatchSize=     Events per upload request (default 1000)
+ *   -MaxInFlight=   Upload requests sent concurrently (default 4)
+ *   -DedupContent   Drop events whose JSON matches one of the recent events. Off by default: events have no
+ *                   unique ID, so two real events with the same data in the same second look identical
+ *   -DedupWindow=   Number of recent events remembered by -DedupContent (default 4000000)
+ *   -Progress=      Progress file (default Saved/Analytics/TokebiOfflineEvents.<export|upload>.progress)
+ *   -Resume         Continue from the progress file instead of starting over. Refused if the file was
+ *                   saved by a run with a different mode, export file or endpoint
+ */
+UCLASS()
+class TOKEBIANALYTICS_API UTokebiOfflineEventsCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UTokebiOfflineEventsCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,223 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiOfflineEventReader.h"
+#include "TokebiOfflineEventsCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Each test gets an empty directory of its own under the automation transient dir
+static FString MakeOfflineTestDir(const FString& TestName)
+{
+    const FString Dir = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("TokebiOfflineEvents") / TestName);
+    IFileManager::Get().DeleteDirectory(*Dir, false, true);
+    IFileManager::Get().MakeDirectory(*Dir, true);
+    return Dir;
+}
+
+static TArray<TSharedPtr<FJsonObject>> ReadAllEvents(const FString& FilePath, bool& bOutError)
+{
+    TArray<TSharedPtr<FJsonObject>> Events;
+    TUniquePtr<FTokebiOfflineEventReader> Reader = FTokebiOfflineEventReader::Open(FilePath);
+    if (!Reader)
+    {
+        bOutError = true;
+        return Events;
+    }
+
+    TSharedPtr<FJsonObject> Event;
+    while (Reader->ReadNext(Event))
+    {
+        Events.Add(Event);
+    }
+    bOutError = Reader->HasError();
+    return Events;
+}
+
+// Event types of an NDJSON export, in file order. Lines that aren't an event come back as "<invalid>".
+static TArray<FString> ReadExportedEventTypes(const FString& FilePath)
+{
+    TArray<FString> Lines;
+    FFileHelper::LoadFileToStringArray(Lines, *FilePath);
+
+    TArray<FString> EventTypes;
+    for (const FString& Line : Lines)
+    {
+        TSharedPtr<FJsonObject> Event;
+        FString EventType;
+        const bool bValid = FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Line), Event) && Event.IsValid() &&
+                            Event->TryGetStringField(TEXT("eventType"), EventType);
+        EventTypes.Add(bValid ? EventType : TEXT("<invalid>"));
+    }
+    return EventTypes;
+}
+
+static int32 RunOfflineEventsCommandlet(const FString& Params)
+{
+    return NewObject<UTokebiOfflineEventsCommandlet>()->Main(Params);
+}
+
+// A store cut off mid-write yields every complete event before the cut, then reports the error
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiOfflineTruncatedStoreTest, "TokebiAnalytics.OfflineEvents.Reader.TruncatedArrayStore",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiOfflineTruncatedStoreTest::RunTest(const FString& Parameters)
+{
+    const FString StorePath = MakeOfflineTestDir(TEXT("Truncated")) / TEXT("TokebiOfflineEvents.json");
+    FFileHelper::SaveStringToFile(TEXT("[{\"eventType\":\"first\",\"payload\":{\"level\":\"1\"}},")
+                                  TEXT("{\"eventType\":\"second\",\"payload\":{\"nested\":{\"list\":[1,2]}}},")
+                                  TEXT("{\"eventType\":\"third\",\"payl"), *StorePath);
+
+    AddExpectedError(TEXT("ended unexpectedly"), EAutomationExpectedErrorFlags::Contains, 1);
+
+    bool bError = false;
+    const TArray<TSharedPtr<FJsonObject>> Events = ReadAllEvents(StorePath, bError);
+
+    TestTrue(TEXT("Truncation is reported"), bError);
+    if (TestEqual(TEXT("Complete events read"), Events.Num(), 2))
+    {
+        TestEqual(TEXT("First event"), Events[0]->GetStringField(TEXT("eventType")), FString(TEXT("first")));
+        TestEqual(TEXT("First payload"), Events[0]->GetObjectField(TEXT("payload"))->GetStringField(TEXT("level")), FString(TEXT("1")));
+        TestEqual(TEXT("Second event"), Events[1]->GetStringField(TEXT("eventType")), FString(TEXT("second")));
+        TestEqual(TEXT("Nested array"), Events[1]->GetObjectField(TEXT("payload"))->GetObjectField(TEXT("nested"))->GetArrayField(TEXT("list")).Num(), 2);
+    }
+    return true;
+}
+
+// SaveEventsToFile writes UTF-16 with a BOM as soon as a payload isn't ASCII
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiOfflineUtf16StoreTest, "TokebiAnalytics.OfflineEvents.Reader.Utf16Store",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiOfflineUtf16StoreTest::RunTest(const FString& Parameters)
+{
+    const FString Potion = TEXT("\u30DD\u30FC\u30B7\u30E7\u30F3"); // Japanese "potion"
+    const FString Turtle = TEXT("\u017B\u00F3\u0142w");              // Polish "turtle"
+
+    const FString StorePath = MakeOfflineTestDir(TEXT("Utf16")) / TEXT("TokebiOfflineEvents.json");
+    FFileHelper::SaveStringToFile(FString::Printf(TEXT("[{\"eventType\":\"item_purchase\",\"payload\":{\"item_id\":\"%s\"}},")
+                                                  TEXT("{\"eventType\":\"pet_named\",\"payload\":{\"name\":\"%s\"}}]"), *Potion, *Turtle),
+                                  *StorePath);
+
+    TArray<uint8> Bytes;
+    FFileHelper::LoadFileToArray(Bytes, *StorePath);
+    TestTrue(TEXT("Store written as UTF-16 with a BOM"), Bytes.Num() >= 2 && Bytes[0] == 0xFF && Bytes[1] == 0xFE);
+
+    bool bError = false;
+    const TArray<TSharedPtr<FJsonObject>> Events = ReadAllEvents(StorePath, bError);
+
+    TestFalse(TEXT("No error"), bError);
+    if (TestEqual(TEXT("Events read"), Events.Num(), 2))
+    {
+        TestEqual(TEXT("Japanese payload"), Events[0]->GetObjectField(TEXT("payload"))->GetStringField(TEXT("item_id")), Potion);
+        TestEqual(TEXT("Polish payload"), Events[1]->GetObjectField(TEXT("payload"))->GetStringField(TEXT("name")), Turtle);
+    }
+    return true;
+}
+
+// A bad line only costs that line; CRLF endings, blank lines, a BOM and a missing final newline are all fine
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiOfflineNdjsonBadLineTest, "TokebiAnalytics.OfflineEvents.Reader.NdjsonBadLine",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiOfflineNdjsonBadLineTest::RunTest(const FString& Parameters)
+{
+    const FString Potion = TEXT("\u30DD\u30FC\u30B7\u30E7\u30F3");
+
+    const FString StorePath = MakeOfflineTestDir(TEXT("Ndjson")) / TEXT("events.ndjson");
+    FFileHelper::SaveStringToFile(FString::Printf(TEXT("{\"eventType\":\"first\",\"payload\":{\"item_id\":\"%s\"}}\r\n")
+                                                  TEXT("{\"eventType\":\"cut_off\",\n")
+                                                  TEXT("\n")
+                                                  TEXT("not json\n")
+                                                  TEXT("{\"eventType\":\"last\"}"), *Potion),
+                                  *StorePath, FFileHelper::EEncodingOptions::ForceUTF8);
+
+    AddExpectedError(TEXT("Skipping unparseable line"), EAutomationExpectedErrorFlags::Contains, 2);
+
+    bool bError = false;
+    const TArray<TSharedPtr<FJsonObject>> Events = ReadAllEvents(StorePath, bError);
+
+    TestFalse(TEXT("Bad lines don't stop the store"), bError);
+    if (TestEqual(TEXT("Events read"), Events.Num(), 2))
+    {
+        TestEqual(TEXT("First event"), Events[0]->GetStringField(TEXT("eventType")), FString(TEXT("first")));
+        TestEqual(TEXT("UTF-8 payload"), Events[0]->GetObjectField(TEXT("payload"))->GetStringField(TEXT("item_id")), Potion);
+        TestEqual(TEXT("Last event"), Events[1]->GetStringField(TEXT("eventType")), FString(TEXT("last")));
+    }
+    return true;
+}
+
+/**
+ * An export interrupted after its last checkpoint leaves a half-written line behind. -Resume must cut
+ * it off, skip the stores already done and carry on, ending with exactly what one clean run writes.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiOfflineResumeExportTest, "TokebiAnalytics.OfflineEvents.Commandlet.ResumeExport",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiOfflineResumeExportTest::RunTest(const FString& Parameters)
+{
+    const FString Dir = MakeOfflineTestDir(TEXT("Resume"));
+    const FString FirstStore = Dir / TEXT("machine01.json");
+    const FString SecondStore = Dir / TEXT("machine02.ndjson");
+    const FString ExportPath = Dir / TEXT("export.ndjson");
+    const FString ProgressPath = Dir / TEXT("export.progress");
+
+    FFileHelper::SaveStringToFile(TEXT("[{\"eventType\":\"a1\"},{\"eventType\":\"a2\"},{\"eventType\":\"a3\"}]"), *FirstStore);
+    FFileHelper::SaveStringToFile(TEXT("{\"eventType\":\"b1\"}\n{\"eventType\":\"b2\"}\n"), *SecondStore, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+
+    // First run only gets through the first store
+    TestEqual(TEXT("First run succeeds"), RunOfflineEventsCommandlet(FString::Printf(TEXT("-Input=\"%s\" -Export=\"%s\" -Progress=\"%s\""),
+                                                                                     *FirstStore, *ExportPath, *ProgressPath)), 0);
+
+    // ...and is killed while writing the next event
+    TUniquePtr<FArchive> Output(IFileManager::Get().CreateFileWriter(*ExportPath, FILEWRITE_Append));
+    const ANSICHAR Partial[] = "{\"eventType\":\"b1\",\"pay";
+    Output->Serialize((void*)Partial, sizeof(Partial) - 1);
+    Output.Reset();
+
+    TestEqual(TEXT("Resumed run succeeds"), RunOfflineEventsCommandlet(FString::Printf(TEXT("-Input=\"%s+%s\" -Export=\"%s\" -Progress=\"%s\" -Resume"),
+                                                                                       *FirstStore, *SecondStore, *ExportPath, *ProgressPath)), 0);
+
+    const TArray<FString> Expected = { TEXT("a1"), TEXT("a2"), TEXT("a3"), TEXT("b1"), TEXT("b2") };
+    TestEqual(TEXT("Exported events"), FString::Join(ReadExportedEventTypes(ExportPath), TEXT(",")), FString::Join(Expected, TEXT(",")));
+
+    // The progress belongs to this export file; resuming an export elsewhere from it is refused
+    AddExpectedError(TEXT("was saved by"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestEqual(TEXT("Resume into another export file is refused"), RunOfflineEventsCommandlet(FString::Printf(TEXT("-Input=\"%s\" -Export=\"%s\" -Progress=\"%s\" -Resume"),
+                                                                                                            *FirstStore, *(Dir / TEXT("other.ndjson")), *ProgressPath)), 1);
+    return true;
+}
+
+// Identical events in the same second are real events, not duplicates, and a store listed twice is read once
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiOfflineDuplicatesTest, "TokebiAnalytics.OfflineEvents.Commandlet.KeepsIdenticalEvents",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiOfflineDuplicatesTest::RunTest(const FString& Parameters)
+{
+    const FString Dir = MakeOfflineTestDir(TEXT("Duplicates"));
+    const FString StoreDir = Dir / TEXT("Stores");
+    const FString StorePath = StoreDir / TEXT("TokebiOfflineEvents.json");
+    const FString ProgressPath = Dir / TEXT("export.progress");
+
+    // Two kills with the same weapon in the same second, as 1.0.0 stored them
+    IFileManager::Get().MakeDirectory(*StoreDir, true);
+    FFileHelper::SaveStringToFile(TEXT("[{\"eventType\":\"enemy_killed\",\"payload\":{\"weapon\":\"rifle\",\"timestamp\":\"2025-08-20T10:00:00.000Z\"}},")
+                                  TEXT("{\"eventType\":\"enemy_killed\",\"payload\":{\"weapon\":\"rifle\",\"timestamp\":\"2025-08-20T10:00:00.000Z\"}}]"), *StorePath);
+
+    // The store both through its directory and by name
+    const FString DefaultExport = Dir / TEXT("default.ndjson");
+    TestEqual(TEXT("Export succeeds"), RunOfflineEventsCommandlet(FString::Printf(TEXT("-Input=\"%s+%s\" -Export=\"%s\" -Progress=\"%s\""),
+                                                                                  *StoreDir, *StorePath, *DefaultExport, *ProgressPath)), 0);
+    TestEqual(TEXT("Both kills exported once each"), ReadExportedEventTypes(DefaultExport).Num(), 2);
+
+    const FString DedupExport = Dir / TEXT("dedup.ndjson");
+    TestEqual(TEXT("Export with -DedupContent succeeds"), RunOfflineEventsCommandlet(FString::Printf(TEXT("-Input=\"%s\" -Export=\"%s\" -Progress=\"%s\" -DedupContent"),
+                                                                                                     *StorePath, *DedupExport, *ProgressPath)), 0);
+    TestEqual(TEXT("-DedupContent merges identical events"), ReadExportedEventTypes(DedupExport).Num(), 1);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
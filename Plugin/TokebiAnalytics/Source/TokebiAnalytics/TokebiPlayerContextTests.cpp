@@ -0,0 +1,93 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsFunctions.h"
+#include "HAL/PlatformTime.h"
+
+static const uint32 PLAYER_CONTEXT_MOCK_PORT = 18710;
+static const int32 BENCHMARK_EVENTS_PER_CONTEXT = 50;
+
+/**
+ * Server tracking throughput: N player contexts each tracking a burst of events, as a dedicated
+ * server would during a busy match. Reports the enqueue rate, the slowest single tracking call (a
+ * forced flush serializes and sends from inside it), how many batches were forced out while
+ * tracking, and the time until the mock endpoint has acknowledged everything.
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FTokebiPlayerContextThroughputTest, "TokebiAnalytics.PlayerContexts.Throughput",
+                                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+void FTokebiPlayerContextThroughputTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+    for (const int32 NumContexts : { 100, 250, 500 })
+    {
+        OutBeautifiedNames.Add(FString::Printf(TEXT("%d contexts"), NumContexts));
+        OutTestCommands.Add(FString::FromInt(NumContexts));
+    }
+}
+
+bool FTokebiPlayerContextThroughputTest::RunTest(const FString& Parameters)
+{
+    const int32 NumContexts = FCString::Atoi(*Parameters);
+
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(PLAYER_CONTEXT_MOCK_PORT);
+    Environment->SetEndpoints(Server->GetBaseUrl(), TArray<FString>());
+
+    TArray<FTokebiPlayerContext> Contexts;
+    for (int32 Index = 0; Index < NumContexts; Index++)
+    {
+        FTokebiPlayerContext Context = UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(FString::Printf(TEXT("bench_player_%d"), Index));
+        UTokebiAnalyticsFunctions::TokebiStartContextSession(Context);
+        Contexts.Add(Context);
+    }
+
+    // Interleave players the way a server tick would
+    const uint32 BatchesBefore = FTokebiAnalyticsTestAccess::GetBatchesCreated();
+    const double StartTime = FPlatformTime::Seconds();
+
+    double SlowestCallSeconds = 0.0;
+    TMap<FString, FString> EventData;
+    EventData.Add(TEXT("weapon"), TEXT("rifle"));
+    for (int32 Round = 0; Round < BENCHMARK_EVENTS_PER_CONTEXT; Round++)
+    {
+        EventData.Add(TEXT("round"), FString::FromInt(Round));
+        for (const FTokebiPlayerContext& Context : Contexts)
+        {
+            const double CallStartTime = FPlatformTime::Seconds();
+            UTokebiAnalyticsFunctions::TokebiTrackForContext(Context, TEXT("enemy_killed"), EventData);
+            SlowestCallSeconds = FMath::Max(SlowestCallSeconds, FPlatformTime::Seconds() - CallStartTime);
+        }
+    }
+
+    const double TrackSeconds = FPlatformTime::Seconds() - StartTime;
+    const uint32 ForcedBatches = FTokebiAnalyticsTestAccess::GetBatchesCreated() - BatchesBefore;
+    const int32 TrackedEvents = NumContexts * BENCHMARK_EVENTS_PER_CONTEXT;
+    const int32 ExpectedEvents = NumContexts * (BENCHMARK_EVENTS_PER_CONTEXT + 1); // Plus each session_start
+
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("every event acknowledged by the mock endpoint"), [Server, ExpectedEvents]()
+    {
+        return Server->ReceivedEvents.Num() >= ExpectedEvents;
+    }, 60.0);
+
+    TokebiAddStep([this, Environment, Server, NumContexts, TrackedEvents, ExpectedEvents, TrackSeconds, SlowestCallSeconds, ForcedBatches, BatchesBefore, StartTime]()
+    {
+        const uint32 TotalBatches = FTokebiAnalyticsTestAccess::GetBatchesCreated() - BatchesBefore;
+
+        AddInfo(FString::Printf(TEXT("%d contexts: %d events tracked in %.1f ms (%.0f events/s, %.2f us/event, slowest call %.2f ms), %u batches forced while tracking, %u total (largest %d events), all acknowledged after %.0f ms"),
+                                NumContexts, TrackedEvents, TrackSeconds * 1000.0, TrackedEvents / TrackSeconds, TrackSeconds * 1000000.0 / TrackedEvents,
+                                SlowestCallSeconds * 1000.0, ForcedBatches, TotalBatches, Server->LargestBatchEvents, (FPlatformTime::Seconds() - StartTime) * 1000.0));
+
+        TestEqual(TEXT("Events received"), Server->ReceivedEvents.Num(), ExpectedEvents);
+
+        // However many players there are, no request (and no serialization on a tracking call) goes past the cap
+        TestTrue(FString::Printf(TEXT("Largest batch (%d events) within the per-request cap"), Server->LargestBatchEvents),
+                 Server->LargestBatchEvents <= FTokebiAnalyticsTestAccess::GetMaxBatchEvents());
+    });
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,369 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsFunctions.h"
+#include "TokebiAnalyticsSettings.h"
+#include "Dom/JsonObject.h"
+#include "Math/RandomStream.h"
+
+static const uint32 STATE_MOCK_PORT = 18730;
+
+// Rounds tracked between flushes; kept under the forced-flush limit so batches arrive in order
+static const int32 WORKLOAD_ROUNDS_PER_FLUSH = 25;
+static const int32 WORKLOAD_ROUNDS = 200;
+
+static int64 GetStateBytes(const FString& Key, const FString& Value)
+{
+    return (Key.Len() + Value.Len()) * sizeof(TCHAR);
+}
+
+// Rebuilds a state the way the server does: a keyframe replaces it, a delta patches it
+static void ApplyStateEvent(TMap<FString, FString>& State, const TSharedPtr<FJsonObject>& Event)
+{
+    if (Event->GetStringField(TEXT("eventType")) == TEXT("state_keyframe"))
+    {
+        State.Reset();
+    }
+
+    for (const auto& Field : Event->GetObjectField(TEXT("payload"))->Values)
+    {
+        State.Add(Field.Key, Field.Value->AsString());
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* RemovedKeys = nullptr;
+    if (Event->TryGetArrayField(TEXT("removedKeys"), RemovedKeys))
+    {
+        for (const TSharedPtr<FJsonValue>& Key : *RemovedKeys)
+        {
+            State.Remove(Key->AsString());
+        }
+    }
+}
+
+static TArray<TSharedPtr<FJsonObject>> GetStateEvents(const FTokebiMockIngestionServer& Server, const FString& StateName)
+{
+    return Server.ReceivedEvents.FilterByPredicate([&StateName](const TSharedPtr<FJsonObject>& Event)
+    {
+        FString EventStateName;
+        return Event->TryGetStringField(TEXT("stateName"), EventStateName) && EventStateName == StateName;
+    });
+}
+
+// One state sampled every round of the workload, and how it drifts between samples
+struct FTokebiStateWorkload
+{
+    FString Name;
+    TMap<FString, FString> State;
+    TFunction<void(TMap<FString, FString>& State, FRandomStream& Random, int32 Round)> Mutate;
+
+    // What sending the full snapshot every time would cost
+    int64 Snapshots = 0;
+    int64 SnapshotFields = 0;
+    int64 SnapshotBytes = 0;
+};
+
+static TArray<TSharedRef<FTokebiStateWorkload>> MakeStateWorkloads()
+{
+    TArray<TSharedRef<FTokebiStateWorkload>> Workloads;
+
+    // 40 item stacks and gold: gold moves most rounds, an item now and then, the item set rarely
+    TSharedRef<FTokebiStateWorkload> Inventory = MakeShared<FTokebiStateWorkload>();
+    Inventory->Name = TEXT("inventory");
+    Inventory->State.Add(TEXT("gold"), TEXT("500"));
+    for (int32 Index = 0; Index < 40; Index++)
+    {
+        Inventory->State.Add(FString::Printf(TEXT("item_%02d"), Index), TEXT("1"));
+    }
+    Inventory->Mutate = [](TMap<FString, FString>& State, FRandomStream& Random, int32 Round)
+    {
+        if (Random.FRand() < 0.6f)
+        {
+            State.Add(TEXT("gold"), FString::FromInt(Random.RandRange(0, 10000)));
+        }
+        if (Random.FRand() < 0.3f)
+        {
+            State.Add(FString::Printf(TEXT("item_%02d"), Random.RandRange(0, 39)), FString::FromInt(Random.RandRange(1, 99)));
+        }
+        if (Round % 50 == 49)
+        {
+            State.Remove(FString::Printf(TEXT("item_%02d"), Round / 50));
+            State.Add(FString::Printf(TEXT("quest_item_%d"), Round / 50), TEXT("1"));
+        }
+    };
+    Workloads.Add(Inventory);
+
+    // Position every round, combat stats often, the rest seldom
+    TSharedRef<FTokebiStateWorkload> Status = MakeShared<FTokebiStateWorkload>();
+    Status->Name = TEXT("player_status");
+    for (const TCHAR* Key : { TEXT("health"), TEXT("armor"), TEXT("ammo"), TEXT("pos_x"), TEXT("pos_y"), TEXT("pos_z"),
+                              TEXT("zone"), TEXT("weapon"), TEXT("level"), TEXT("xp"), TEXT("stance"), TEXT("vehicle") })
+    {
+        Status->State.Add(Key, TEXT("0"));
+    }
+    Status->Mutate = [](TMap<FString, FString>& State, FRandomStream& Random, int32 Round)
+    {
+        State.Add(TEXT("pos_x"), FString::SanitizeFloat(Random.FRandRange(-5000.0f, 5000.0f)));
+        State.Add(TEXT("pos_y"), FString::SanitizeFloat(Random.FRandRange(-5000.0f, 5000.0f)));
+        if (Random.FRand() < 0.3f)
+        {
+            State.Add(TEXT("pos_z"), FString::SanitizeFloat(Random.FRandRange(0.0f, 500.0f)));
+        }
+        if (Random.FRand() < 0.5f)
+        {
+            State.Add(TEXT("ammo"), FString::FromInt(Random.RandRange(0, 120)));
+        }
+        if (Random.FRand() < 0.2f)
+        {
+            State.Add(TEXT("health"), FString::FromInt(Random.RandRange(1, 100)));
+        }
+        if (Random.FRand() < 0.05f)
+        {
+            State.Add(TEXT("zone"), FString::Printf(TEXT("zone_%d"), Random.RandRange(1, 12)));
+        }
+    };
+    Workloads.Add(Status);
+
+    // Settings that almost never change
+    TSharedRef<FTokebiStateWorkload> Settings = MakeShared<FTokebiStateWorkload>();
+    Settings->Name = TEXT("settings");
+    for (int32 Index = 0; Index < 25; Index++)
+    {
+        Settings->State.Add(FString::Printf(TEXT("option_%02d"), Index), TEXT("default"));
+    }
+    Settings->Mutate = [](TMap<FString, FString>& State, FRandomStream& Random, int32 Round)
+    {
+        if (Random.FRand() < 0.02f)
+        {
+            State.Add(FString::Printf(TEXT("option_%02d"), Random.RandRange(0, 24)), FString::Printf(TEXT("value_%d"), Round));
+        }
+    };
+    Workloads.Add(Settings);
+
+    return Workloads;
+}
+
+/**
+ * Typical snapshot workloads (inventory, player status, settings) sampled every round with a fixed
+ * seed. Reports how many events and payload bytes delta encoding saves over sending every snapshot
+ * in full, and checks that replaying the received keyframes and deltas rebuilds the final state.
+ * Coalescing is on, so it also guards against state events being merged.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiStateTrackingWorkloadTest, "TokebiAnalytics.StateTracking.Workload",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiStateTrackingWorkloadTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(STATE_MOCK_PORT);
+    Environment->SetEndpoints(Server->GetBaseUrl(), TArray<FString>());
+
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    Settings->bCoalesceDuplicateEvents = true;
+    Settings->StateKeyframeInterval = 10;
+    Settings->StateKeyframeSeconds = 300.0f;
+
+    TArray<TSharedRef<FTokebiStateWorkload>> Workloads = MakeStateWorkloads();
+    TSharedRef<FRandomStream> Random = MakeShared<FRandomStream>(0x70CEB1);
+    const uint32 BatchesBefore = FTokebiAnalyticsTestAccess::GetBatchesCreated();
+
+    for (int32 FirstRound = 0; FirstRound < WORKLOAD_ROUNDS; FirstRound += WORKLOAD_ROUNDS_PER_FLUSH)
+    {
+        TokebiAddStep([Workloads, Random, FirstRound]()
+        {
+            for (int32 Round = FirstRound; Round < FirstRound + WORKLOAD_ROUNDS_PER_FLUSH; Round++)
+            {
+                for (const TSharedRef<FTokebiStateWorkload>& Workload : Workloads)
+                {
+                    Workload->Mutate(Workload->State, *Random, Round);
+
+                    Workload->Snapshots++;
+                    Workload->SnapshotFields += Workload->State.Num();
+                    Workload->SnapshotBytes += Workload->Name.Len() * sizeof(TCHAR);
+                    for (const auto& Pair : Workload->State)
+                    {
+                        Workload->SnapshotBytes += GetStateBytes(Pair.Key, Pair.Value);
+                    }
+
+                    UTokebiAnalyticsFunctions::TokebiTrackState(Workload->Name, Workload->State);
+                }
+            }
+            UTokebiAnalyticsFunctions::TokebiFlushEvents();
+        });
+
+        // One batch at a time, so the mock sees events in the order they were tracked
+        TokebiAddWaitUntil(this, TEXT("batch acknowledged"), [Server, BatchesBefore]()
+        {
+            return (uint32)Server->TrackRequests >= FTokebiAnalyticsTestAccess::GetBatchesCreated() - BatchesBefore;
+        });
+    }
+
+    TokebiAddStep([this, Environment, Server, Workloads]()
+    {
+        int64 TotalSnapshots = 0;
+        int64 TotalEvents = 0;
+        int64 TotalSnapshotBytes = 0;
+        int64 TotalSentBytes = 0;
+
+        for (const TSharedRef<FTokebiStateWorkload>& Workload : Workloads)
+        {
+            const TArray<TSharedPtr<FJsonObject>> Events = GetStateEvents(*Server, Workload->Name);
+
+            TMap<FString, FString> Rebuilt;
+            int64 SentFields = 0;
+            int64 SentBytes = 0;
+            for (const TSharedPtr<FJsonObject>& Event : Events)
+            {
+                ApplyStateEvent(Rebuilt, Event);
+
+                SentBytes += Workload->Name.Len() * sizeof(TCHAR);
+                for (const auto& Field : Event->GetObjectField(TEXT("payload"))->Values)
+                {
+                    SentFields++;
+                    SentBytes += GetStateBytes(Field.Key, Field.Value->AsString());
+                }
+                const TArray<TSharedPtr<FJsonValue>>* RemovedKeys = nullptr;
+                if (Event->TryGetArrayField(TEXT("removedKeys"), RemovedKeys))
+                {
+                    for (const TSharedPtr<FJsonValue>& Key : *RemovedKeys)
+                    {
+                        SentFields++;
+                        SentBytes += Key->AsString().Len() * sizeof(TCHAR);
+                    }
+                }
+            }
+
+            TestTrue(FString::Printf(TEXT("%s rebuilds to the last snapshot"), *Workload->Name), Rebuilt.OrderIndependentCompareEqual(Workload->State));
+
+            AddInfo(FString::Printf(TEXT("%s: %lld snapshots sent as %d events (%.1f%% fewer), %lld of %lld fields, %.1f%% fewer payload bytes"),
+                                    *Workload->Name, Workload->Snapshots, Events.Num(), 100.0 * (Workload->Snapshots - Events.Num()) / Workload->Snapshots,
+                                    SentFields, Workload->SnapshotFields, 100.0 * (Workload->SnapshotBytes - SentBytes) / Workload->SnapshotBytes));
+
+            TotalSnapshots += Workload->Snapshots;
+            TotalEvents += Events.Num();
+            TotalSnapshotBytes += Workload->SnapshotBytes;
+            TotalSentBytes += SentBytes;
+        }
+
+        AddInfo(FString::Printf(TEXT("All states: %lld snapshots sent as %lld events (%.1f%% fewer), %.1f%% fewer payload bytes"),
+                                TotalSnapshots, TotalEvents, 100.0 * (TotalSnapshots - TotalEvents) / TotalSnapshots,
+                                100.0 * (TotalSnapshotBytes - TotalSentBytes) / TotalSnapshotBytes));
+        TestTrue(TEXT("Delta encoding sends fewer payload bytes than full snapshots"), TotalSentBytes < TotalSnapshotBytes);
+    });
+
+    return true;
+}
+
+// Repeating deltas must not be merged by coalescing: gold 5 -> 3 -> 5 -> 3 has to rebuild as 3
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiStateTrackingOrderTest, "TokebiAnalytics.StateTracking.DeltasKeepOrderWithCoalescing",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiStateTrackingOrderTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(STATE_MOCK_PORT + 1);
+    Environment->SetEndpoints(Server->GetBaseUrl(), TArray<FString>());
+
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+    Settings->bCoalesceDuplicateEvents = true;
+    Settings->StateKeyframeInterval = 0;
+    Settings->StateKeyframeSeconds = 0.0f;
+
+    TMap<FString, FString> Wallet;
+    for (const TCHAR* Gold : { TEXT("5"), TEXT("3"), TEXT("5"), TEXT("3") })
+    {
+        Wallet.Add(TEXT("gold"), Gold);
+        UTokebiAnalyticsFunctions::TokebiTrackState(TEXT("wallet"), Wallet);
+    }
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("wallet events received"), [Server]() { return GetStateEvents(*Server, TEXT("wallet")).Num() >= 4; });
+
+    TokebiAddStep([this, Environment, Server]()
+    {
+        const TArray<TSharedPtr<FJsonObject>> Events = GetStateEvents(*Server, TEXT("wallet"));
+        TestEqual(TEXT("Events received"), Events.Num(), 4);
+
+        TMap<FString, FString> Rebuilt;
+        for (const TSharedPtr<FJsonObject>& Event : Events)
+        {
+            TestFalse(TEXT("State events are never coalesced"), Event->HasField(TEXT("count")));
+            ApplyStateEvent(Rebuilt, Event);
+        }
+        TestEqual(TEXT("Rebuilt gold"), Rebuilt.FindRef(TEXT("gold")), FString(TEXT("3")));
+    });
+
+    return true;
+}
+
+// The cache only follows snapshots that were actually queued, and never outlives its context
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiStateTrackingCacheTest, "TokebiAnalytics.StateTracking.CacheFollowsQueue",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiStateTrackingCacheTest::RunTest(const FString& Parameters)
+{
+    FTokebiTestEnvironment Environment;
+    UTokebiAnalyticsSettings* Settings = GetMutableDefault<UTokebiAnalyticsSettings>();
+
+    TMap<FString, FString> State;
+    State.Add(TEXT("gold"), TEXT("10"));
+
+    // Dropped for lack of an API key, so nothing may be remembered as sent
+    const FString ApiKey = Settings->TokebiApiKey;
+    Settings->TokebiApiKey.Empty();
+    AddExpectedError(TEXT("not configured"), EAutomationExpectedErrorFlags::Contains, 0);
+    UTokebiAnalyticsFunctions::TokebiTrackState(TEXT("purse"), State);
+    TestEqual(TEXT("Caches after a dropped snapshot"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 0);
+
+    Settings->TokebiApiKey = ApiKey;
+    UTokebiAnalyticsFunctions::TokebiTrackState(TEXT("purse"), State);
+    TestEqual(TEXT("Caches after a queued snapshot"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 1);
+    TestEqual(TEXT("Queued events"), FTokebiAnalyticsTestAccess::GetQueuedEventCount(), 1);
+
+    // A destroyed context takes its caches with it and can't grow new ones
+    const FTokebiPlayerContext Context = UTokebiAnalyticsFunctions::TokebiCreatePlayerContextWithID(TEXT("state_test_player"));
+    UTokebiAnalyticsFunctions::TokebiTrackStateForContext(Context, TEXT("purse"), State);
+    TestEqual(TEXT("Caches with a live context"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 2);
+
+    UTokebiAnalyticsFunctions::TokebiDestroyPlayerContext(Context);
+    TestEqual(TEXT("Caches after destroying the context"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 1);
+
+    AddExpectedError(TEXT("invalid player context"), EAutomationExpectedErrorFlags::Contains, 0);
+    UTokebiAnalyticsFunctions::TokebiTrackStateForContext(Context, TEXT("purse"), State);
+    TestEqual(TEXT("Caches after tracking a destroyed context"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 1);
+
+    return true;
+}
+
+// A snapshot that fills the queue forces a flush, which waits until the state cache is released
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiStateTrackingForcedFlushTest, "TokebiAnalytics.StateTracking.ForcedFlush",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiStateTrackingForcedFlushTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(STATE_MOCK_PORT + 2);
+    Environment->SetEndpoints(Server->GetBaseUrl(), TArray<FString>());
+
+    TMap<FString, FString> Filler;
+    Filler.Add(TEXT("source"), TEXT("state_test"));
+    while (FTokebiAnalyticsTestAccess::GetQueuedEventCount() < FTokebiAnalyticsTestAccess::GetMaxQueueSize() - 1)
+    {
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("filler"), Filler);
+    }
+    const uint32 BatchesBefore = FTokebiAnalyticsTestAccess::GetBatchesCreated();
+
+    TMap<FString, FString> Purse;
+    Purse.Add(TEXT("gold"), TEXT("10"));
+    UTokebiAnalyticsFunctions::TokebiTrackState(TEXT("purse"), Purse);
+
+    TestEqual(TEXT("Batches created by the snapshot"), (int32)(FTokebiAnalyticsTestAccess::GetBatchesCreated() - BatchesBefore), 1);
+    TestEqual(TEXT("Queued events"), FTokebiAnalyticsTestAccess::GetQueuedEventCount(), 0);
+    TestEqual(TEXT("Caches"), FTokebiAnalyticsTestAccess::GetStateCacheCount(), 1);
+
+    TokebiAddWaitUntil(this, TEXT("purse received"), [Environment, Server]() { return GetStateEvents(*Server, TEXT("purse")).Num() > 0; });
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,90 @@
+#include "TokebiAnalyticsTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TokebiAnalyticsFunctions.h"
+#include "TokebiAnalyticsSettings.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+
+static const uint32 TIMESTAMP_MOCK_PORT = 18740;
+
+// Far enough off to be corrected (the plugin ignores skew under 2 s)
+static const int32 SERVER_CLOCK_AHEAD_SECONDS = 10;
+
+// The Date header has 1 second resolution
+static const int64 SKEW_TOLERANCE_MS = 1500;
+
+static int64 GetLocalUnixTimeMs()
+{
+    return (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+}
+
+static TSharedPtr<FJsonObject> FindReceivedEvent(const FTokebiMockIngestionServer& Server, const FString& EventType)
+{
+    const TSharedPtr<FJsonObject>* Found = Server.ReceivedEvents.FindByPredicate([&EventType](const TSharedPtr<FJsonObject>& Event)
+    {
+        return Event->GetStringField(TEXT("eventType")) == EventType;
+    });
+    return Found ? *Found : nullptr;
+}
+
+/**
+ * An event that fails to send, is saved offline and is sent again after a reload must arrive with
+ * the same skew-corrected time it would have had the first time - corrected once, not once per trip.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTokebiSpilledEventSkewTest, "TokebiAnalytics.Timestamps.SpilledEventsCorrectedOnce",
+                                 EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTokebiSpilledEventSkewTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTokebiTestEnvironment> Environment = MakeShared<FTokebiTestEnvironment>();
+    TSharedRef<FTokebiMockIngestionServer> Server = MakeShared<FTokebiMockIngestionServer>(TIMESTAMP_MOCK_PORT);
+    Server->ClockOffsetSeconds = SERVER_CLOCK_AHEAD_SECONDS;
+    Environment->SetEndpoints(Server->GetBaseUrl(), TArray<FString>());
+    GetMutableDefault<UTokebiAnalyticsSettings>()->bCorrectClockSkew = true;
+
+    // A first batch lets the plugin read the server's clock
+    UTokebiAnalyticsFunctions::TokebiTrack(TEXT("skew_warmup"), TMap<FString, FString>());
+    UTokebiAnalyticsFunctions::TokebiFlushEvents();
+
+    TokebiAddWaitUntil(this, TEXT("warm-up batch received"), [Server]() { return FindReceivedEvent(*Server, TEXT("skew_warmup")).IsValid(); });
+
+    TSharedRef<int64> TrackedAtMs = MakeShared<int64>(0);
+    TokebiAddStep([Server, TrackedAtMs]()
+    {
+        Server->ResponseCode = 503;
+        *TrackedAtMs = GetLocalUnixTimeMs();
+        UTokebiAnalyticsFunctions::TokebiTrack(TEXT("skew_spilled"), TMap<FString, FString>());
+        UTokebiAnalyticsFunctions::TokebiFlushEvents();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("failed batch saved offline"), []()
+    {
+        return IFileManager::Get().FileExists(*FTokebiAnalyticsTestAccess::GetOfflineEventsPath());
+    });
+
+    TokebiAddStep([Server]()
+    {
+        Server->ResponseCode = 200;
+        FTokebiAnalyticsTestAccess::ReloadOfflineEvents();
+        UTokebiAnalyticsFunctions::TokebiFlushEvents();
+    });
+
+    TokebiAddWaitUntil(this, TEXT("reloaded event received"), [Server]() { return FindReceivedEvent(*Server, TEXT("skew_spilled")).IsValid(); });
+
+    TokebiAddStep([this, Environment, Server, TrackedAtMs]()
+    {
+        const TSharedPtr<FJsonObject> Event = FindReceivedEvent(*Server, TEXT("skew_spilled"));
+        const int64 EventMs = (int64)Event->GetNumberField(TEXT("sentAt")) + (int64)Event->GetNumberField(TEXT("timeOffsetMs"));
+        const int64 ExpectedMs = *TrackedAtMs + SERVER_CLOCK_AHEAD_SECONDS * 1000;
+
+        AddInfo(FString::Printf(TEXT("Reloaded event is %lld ms from the server-clock time it was tracked at"), EventMs - ExpectedMs));
+        TestTrue(TEXT("Reloaded event time is the tracked time in server clock, corrected once"), FMath::Abs(EventMs - ExpectedMs) <= SKEW_TOLERANCE_MS);
+    });
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS